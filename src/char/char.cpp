@@ -70,9 +70,11 @@ int subnet_count = 0;
 DBMap* auth_db; // uint32 account_id -> struct auth_node*
 DBMap* online_char_db; // uint32 account_id -> struct online_char_data*
 DBMap* char_db_; // uint32 char_id -> struct mmo_charstatus*
+DBMap* char_savebase_db; // uint32 char_id -> struct mmo_charstatus*, last status received from the map-server (base of delta saves)
 DBMap* char_get_authdb() { return auth_db; }
 DBMap* char_get_onlinedb() { return online_char_db; }
 DBMap* char_get_chardb() { return char_db_; }
+DBMap* char_get_savebasedb() { return char_savebase_db; }
 
 /**
  * @see DBCreateData
@@ -161,6 +163,7 @@ void char_set_char_offline(uint32 char_id, uint32 account_id){
 		inter_guild_CharOffline(char_id, cp?cp->guild_id:-1);
 		if (cp)
 			idb_remove(char_db_,char_id);
+		idb_remove(char_savebase_db,char_id);
 
 		if( SQL_ERROR == Sql_Query(sql_handle, "UPDATE `%s` SET `online`='0' WHERE `char_id`='%d' LIMIT 1", schema_config.char_db, char_id) )
 			Sql_ShowDebug(sql_handle);
@@ -1237,6 +1240,7 @@ int char_mmo_char_fromsql(uint32 char_id, struct mmo_charstatus* p, bool load_ev
 //==========================================================================================================
 int char_mmo_sql_init(void) {
 	char_db_= idb_alloc(DB_OPT_RELEASE_DATA);
+	char_savebase_db = idb_alloc(DB_OPT_RELEASE_DATA);
 
 	ShowStatus("Characters per Account: '%d'.\n", charserv_config.char_config.char_per_account);
 
@@ -2739,6 +2743,7 @@ void char_set_defaults(){
 	safestrncpy(charserv_config.char_config.char_name_letters,"",sizeof(charserv_config.char_config.char_name_letters)); // list of letters/symbols allowed (or not) in a character name. by [Yor]
 
 	charserv_config.save_log = 1; // show loading/saving messages
+	charserv_config.replay_auth = false;
 	charserv_config.log_char = 1;	// loggin char or not [devil]
 	charserv_config.log_inter = 1;	// loggin inter or not [devil]
 	charserv_config.char_check_db =1;
@@ -2776,6 +2781,7 @@ void char_set_defaults(){
 	charserv_config.max_connect_user = -1;
 	charserv_config.gm_allow_group = -1;
 	charserv_config.autosave_interval = DEFAULT_AUTOSAVE_INTERVAL;
+	charserv_config.guild_save_rate = 100;
 	charserv_config.start_zeny = 0;
 	charserv_config.guild_exp_rate = 100;
 	charserv_config.guild_extension = 6;
@@ -2967,8 +2973,14 @@ bool char_config_read(const char* cfgName, bool normal){
 			charserv_config.autosave_interval = atoi(w2)*1000;
 			if (charserv_config.autosave_interval <= 0)
 				charserv_config.autosave_interval = DEFAULT_AUTOSAVE_INTERVAL;
+		} else if (strcmpi(w1, "guild_save_rate") == 0) {
+			charserv_config.guild_save_rate = atoi(w2);
+			if (charserv_config.guild_save_rate < 10)
+				charserv_config.guild_save_rate = 10;
 		} else if (strcmpi(w1, "save_log") == 0) {
 			charserv_config.save_log = config_switch(w2);
+		} else if (strcmpi(w1, "replay_auth") == 0) {
+			charserv_config.replay_auth = (bool)config_switch(w2);
 #ifdef RENEWAL
 		} else if (strcmpi(w1, "start_point") == 0) {
 #else
@@ -3130,6 +3142,7 @@ void do_final(void)
 	do_final_chlogif();
 
 	char_db_->destroy(char_db_, NULL);
+	char_savebase_db->destroy(char_savebase_db, NULL);
 	online_char_db->destroy(online_char_db, NULL);
 	auth_db->destroy(auth_db, NULL);
 
@@ -166,6 +166,7 @@ struct CharServ_Config {
 #endif
 
 	int save_log; // show loading/saving messages
+	bool replay_auth; // accept map-server logins without auth node, for packet capture replays
 	int log_char;	// loggin char or not [devil]
 	int log_inter;	// loggin inter or not [devil]
 	int char_check_db;	///cheking sql-table at begining ?
@@ -177,6 +178,7 @@ struct CharServ_Config {
 	int max_connect_user;
 	int gm_allow_group;
 	int autosave_interval;
+	int guild_save_rate;
 	int start_zeny;
 	int guild_exp_rate;
 	int guild_extension;
@@ -258,6 +260,8 @@ struct char_session_data {
 
 struct mmo_charstatus;
 DBMap* char_get_chardb(); // uint32 char_id -> struct mmo_charstatus*
+DBMap* char_get_savebasedb(); // uint32 char_id -> struct mmo_charstatus*
+DBData char_create_charstatus(DBKey key, va_list args);
 
 //Custom limits for the fame lists. [Skotlex]
 extern int fame_list_size_chemist;
@@ -13,6 +13,7 @@
 #include "../common/timer.hpp"
 
 #include "char.hpp"
+#include "int_guild.hpp"
 
 /*======================================================
  * Login-Server help option info
@@ -86,12 +87,16 @@ int cnslif_parse(const char* buf)
 	else if( strcmpi("ers_report", type) == 0 ){
 		ers_report();
 	}
+	else if( strcmpi("guildsave_report", type) == 0 ){
+		inter_guild_save_report();
+	}
 	else if( strcmpi("help", type) == 0 ){
 		ShowInfo("Available commands:\n");
 		ShowInfo("\t server:shutdown => Stops the server.\n");
 		ShowInfo("\t server:alive => Checks if the server is running.\n");
 		ShowInfo("\t server:reloadconf => Reload config file: \"%s\"\n", CHAR_CONF_NAME);
 		ShowInfo("\t ers_report => Displays database usage.\n");
+		ShowInfo("\t guildsave_report => Displays the guild save queue and save times.\n");
 	}
 
 	return 0;
@@ -698,6 +698,9 @@ int chmapif_parse_reqsavechar(int fd, int id){
 			RFIFOSKIP(fd,size);
 			return 1;
 		}
+		// Base of the following delta saves (0x2b2c)
+		memcpy(idb_ensure(char_get_savebasedb(), cid, char_create_charstatus), RFIFOP(fd,13), sizeof(struct mmo_charstatus));
+
 		//Check account only if this ain't final save. Final-save goes through because of the char-map reconnect
 		if (RFIFOB(fd,12) || RFIFOB(fd,13) || (
 			(character = (struct online_char_data*)idb_get(online_char_db, aid)) != NULL &&
@@ -725,6 +728,79 @@ int chmapif_parse_reqsavechar(int fd, int id){
 	return 1;
 }
 
+/**
+ * Tells the map-server a delta save could not be applied, the map-server answers with a complete save.
+ * HZ 0x2b29 <account_id>.L <char_id>.L
+ * @param fd: map-server link
+ * @param aid: account id
+ * @param cid: char id
+ */
+static void chmapif_save_delta_nak(int fd, uint32 aid, uint32 cid){
+	WFIFOHEAD(fd,10);
+	WFIFOW(fd,0) = 0x2b29;
+	WFIFOL(fd,2) = aid;
+	WFIFOL(fd,6) = cid;
+	WFIFOSET(fd,10);
+}
+
+/**
+ * Saves a character from the changes since its last save.
+ * The changed byte ranges are applied to the status last received from the map-server.
+ * ZH 0x2b2c <size>.W <account_id>.L <char_id>.L <flag>.B { <offset>.W <length>.W <data>.?B }*
+ * @param fd: map-server link
+ * @param id: map-server index
+ * @return 0 not enough data received, 1 success
+ */
+int chmapif_parse_reqsavechar_delta(int fd, int id){
+	if (RFIFOREST(fd) < 4 || RFIFOREST(fd) < RFIFOW(fd,2))
+		return 0;
+	else {
+		uint32 aid = RFIFOL(fd,4), cid = RFIFOL(fd,8);
+		int size = RFIFOW(fd,2), pos = 13;
+		struct mmo_charstatus* base = (struct mmo_charstatus*)idb_get(char_get_savebasedb(), cid);
+		struct online_char_data* character;
+		struct mmo_charstatus char_dat;
+
+		if (base == NULL) {
+			ShowWarning("parse_from_map (save-char delta): No base for character (%d:%d), requesting a complete save.\n", aid, cid);
+			chmapif_save_delta_nak(fd, aid, cid);
+			RFIFOSKIP(fd,size);
+			return 1;
+		}
+
+		memcpy(&char_dat, base, sizeof(struct mmo_charstatus));
+
+		while (pos + 4 <= size) {
+			uint16 offset = RFIFOW(fd,pos), length = RFIFOW(fd,pos+2);
+
+			if (offset + length > sizeof(struct mmo_charstatus) || pos + 4 + length > size)
+				break;
+			memcpy((uint8*)&char_dat + offset, RFIFOP(fd,pos+4), length);
+			pos += 4 + length;
+		}
+
+		if (pos != size) {
+			ShowError("parse_from_map (save-char delta): Invalid range for character (%d:%d), requesting a complete save.\n", aid, cid);
+			idb_remove(char_get_savebasedb(), cid);
+			chmapif_save_delta_nak(fd, aid, cid);
+			RFIFOSKIP(fd,size);
+			return 1;
+		}
+
+		memcpy(base, &char_dat, sizeof(struct mmo_charstatus));
+
+		if ((character = (struct online_char_data*)idb_get(char_get_onlinedb(), aid)) != NULL && character->char_id == cid)
+			char_mmo_char_tosql(cid, &char_dat);
+		else {
+			ShowError("parse_from_map (save-char delta): Received data for non-existant/offline character (%d:%d).\n", aid, cid);
+			char_set_char_online(id, cid, aid);
+		}
+
+		RFIFOSKIP(fd,size);
+	}
+	return 1;
+}
+
 /**
  * Inform mapserv of a new character selection request
  * @param fd : FD link tomapserv
@@ -1307,7 +1383,8 @@ int chmapif_parse_reqauth(int fd, int id){
 				char_mmo_char_fromsql(char_id, &char_dat, true);
 				cd = (struct mmo_charstatus*)uidb_get(char_db_,char_id);
 		}
-		if( runflag == CHARSERVER_ST_RUNNING && autotrade && cd ){
+		// Replayed packet captures log in with outdated login ids and are accepted like autotraders
+		if( runflag == CHARSERVER_ST_RUNNING && (autotrade || (charserv_config.replay_auth && node == NULL)) && cd ){
 			uint16 mmo_charstatus_len = sizeof(struct mmo_charstatus) + 25;
 			if (cd->sex == SEX_ACCOUNT)
 				cd->sex = sex;
@@ -1316,7 +1393,7 @@ int chmapif_parse_reqauth(int fd, int id){
 			WFIFOW(fd,0) = 0x2afd;
 			WFIFOW(fd,2) = mmo_charstatus_len;
 			WFIFOL(fd,4) = account_id;
-			WFIFOL(fd,8) = 0;
+			WFIFOL(fd,8) = login_id1; // 0 for autotraders
 			WFIFOL(fd,12) = 0;
 			WFIFOL(fd,16) = 0;
 			WFIFOL(fd,20) = 0;
@@ -1735,7 +1812,7 @@ int chmapif_parse(int fd){
 			case 0x2b26: next=chmapif_parse_reqauth(fd,id); break;
 			case 0x2b28: next=chmapif_parse_reqcharban(fd); break; //charban
 			case 0x2b2a: next=chmapif_parse_reqcharunban(fd); break; //charunban
-			//case 0x2b2c: /*free*/; break;
+			case 0x2b2c: next=chmapif_parse_reqsavechar_delta(fd,id); break;
 			case 0x2b2d: next=chmapif_bonus_script_get(fd); break; //Load data
 			case 0x2b2e: next=chmapif_bonus_script_save(fd); break;//Save data
 			default:
@@ -3,9 +3,12 @@
 
 #include "int_guild.hpp"
 
+#include <algorithm>
+#include <deque>
 #include <stdlib.h>
 #define __STDC_WANT_LIB_EXT1__ 1
 #include <string.h>
+#include <unordered_set>
 
 #include "../common/cbasetypes.hpp"
 #include "../common/malloc.hpp"
@@ -26,6 +29,8 @@
 #define GS_POSITION_UNMODIFIED 0x00
 #define GS_POSITION_MODIFIED 0x01
 
+#define GUILD_SAVE_STEP 100 // Interval of guild_save_timer in ms
+
 // LSB = 0 => Alliance, LSB = 1 => Opposition
 #define GUILD_ALLIANCE_TYPE_MASK 0x01
 #define GUILD_ALLIANCE_REMOVE 0x08
@@ -48,48 +53,98 @@ int guild_break_sub(int key,void *data,va_list ap);
 int inter_guild_tosql(struct guild *g,int flag);
 int guild_checkskill(struct guild *g, int id);
 
+/// Guild queued to be saved or unloaded, once it was queued for autosave_interval
+struct s_guild_save_entry {
+	int guild_id;
+	t_tick tick;
+};
+
+static std::deque<s_guild_save_entry> guild_save_queue;
+static std::unordered_set<int> guild_save_queued; // guild ids in guild_save_queue
+
+/// Statistics of the guild save queue, see inter_guild_save_report
+static struct {
+	uint64 saves;
+	uint64 save_time; // ms spent in inter_guild_tosql
+	t_tick save_time_max;
+	uint64 delay; // ms guilds stayed queued beyond autosave_interval
+	t_tick delay_max;
+	size_t depth_max;
+} guild_save_stats;
+
+/**
+ * Flags data of a guild to be saved and queues the guild.
+ * Flags set while the guild is queued are saved together.
+ * @param g: guild
+ * @param flag: GS_* data to save, GS_REMOVE to unload the guild once nothing is left to save
+ */
+void inter_guild_save_flag(struct guild *g, int flag)
+{
+	g->save_flag |= flag;
+
+	if (guild_save_queued.insert(g->guild_id).second) {
+		guild_save_queue.push_back({ g->guild_id, gettick() });
+		guild_save_stats.depth_max = std::max(guild_save_stats.depth_max, guild_save_queue.size());
+	}
+}
+
+/**
+ * Saves and unloads the queued guilds that are due.
+ * At most guild_save_rate guilds are saved per second, the rest waits for the next run.
+ */
 TIMER_FUNC(guild_save_timer){
-	static int last_id = 0; //To know in which guild we were.
-	int state = 0; //0: Have not reached last guild. 1: Reached last guild, ready for save. 2: Some guild saved, don't do further saving.
-	DBIterator *iter = db_iterator(guild_db_);
-	DBKey key;
-	struct guild* g;
+	int budget = std::max(1, charserv_config.guild_save_rate * GUILD_SAVE_STEP / 1000);
 
-	if( last_id == 0 ) //Save the first guild in the list.
-		state = 1;
+	while (!guild_save_queue.empty() && budget > 0) {
+		s_guild_save_entry entry = guild_save_queue.front();
+		t_tick delay = DIFF_TICK(tick, entry.tick) - charserv_config.autosave_interval;
+		struct guild *g;
+
+		if (delay < 0)
+			break; // the rest of the queue is not due yet
+
+		guild_save_queue.pop_front();
+		guild_save_queued.erase(entry.guild_id);
+
+		if ((g = (struct guild*)idb_get(guild_db_, entry.guild_id)) == NULL)
+			continue; // broken since
+
+		if (g->save_flag&GS_MASK) {
+			t_tick start = gettick_nocache(), duration;
 
-	for( g = (struct guild*)db_data2ptr(iter->first(iter, &key)); dbi_exists(iter); g = (struct guild*)db_data2ptr(iter->next(iter, &key)) )
-	{
-		if( state == 0 && g->guild_id == last_id )
-			state++; //Save next guild in the list.
-		else if( state == 1 && g->save_flag&GS_MASK )
-		{
 			inter_guild_tosql(g, g->save_flag&GS_MASK);
 			g->save_flag &= ~GS_MASK;
-
-			//Some guild saved.
-			last_id = g->guild_id;
-			state++;
+			budget--;
+
+			duration = DIFF_TICK(gettick_nocache(), start);
+			guild_save_stats.saves++;
+			guild_save_stats.save_time += duration;
+			guild_save_stats.save_time_max = std::max(guild_save_stats.save_time_max, duration);
+			guild_save_stats.delay += delay;
+			guild_save_stats.delay_max = std::max(guild_save_stats.delay_max, delay);
 		}
 
-		if( g->save_flag == GS_REMOVE )
-		{// Nothing to save, guild is ready for removal.
+		if (g->save_flag == GS_REMOVE) {// Nothing to save, guild is ready for removal.
 			if (charserv_config.save_log)
 				ShowInfo("Guild Unloaded (%d - %s)\n", g->guild_id, g->name);
-			db_remove(guild_db_, key);
+			idb_remove(guild_db_, entry.guild_id);
 		}
 	}
-	dbi_destroy(iter);
 
-	if( state != 2 ) //Reached the end of the guild db without saving.
-		last_id = 0; //Reset guild saved, return to beginning.
-
-	state = guild_db_->size(guild_db_);
-	if( state < 1 ) state = 1; //Calculate the time slot for the next save.
-	add_timer(tick  + (charserv_config.autosave_interval)/state, guild_save_timer, 0, 0);
 	return 0;
 }
 
+/**
+ * Shows the statistics of the guild save queue on the console.
+ */
+void inter_guild_save_report(void)
+{
+	ShowInfo("Guild save queue: " CL_WHITE "%" PRIuPTR CL_RESET " guilds queued (at most %" PRIuPTR "), %d cached.\n", guild_save_queue.size(), guild_save_stats.depth_max, guild_db_->size(guild_db_));
+	if (guild_save_stats.saves > 0)
+		ShowInfo("Guild saves: " CL_WHITE "%" PRIu64 CL_RESET ", %" PRIu64 " ms on average (at most %" PRId64 " ms), saved %" PRIu64 " ms after autosave_time on average (at most %" PRId64 " ms).\n",
+			guild_save_stats.saves, guild_save_stats.save_time / guild_save_stats.saves, guild_save_stats.save_time_max, guild_save_stats.delay / guild_save_stats.saves, guild_save_stats.delay_max);
+}
+
 int inter_guild_removemember_tosql(uint32 char_id)
 {
 	if( SQL_ERROR == Sql_Query(sql_handle, "DELETE from `%s` where `char_id` = '%d'", schema_config.guild_member_db, char_id) )
@@ -526,7 +581,7 @@ struct guild * inter_guild_fromsql(int guild_id)
 	Sql_FreeResult(sql_handle);
 
 	idb_put(guild_db_, guild_id, g); //Add to cache
-	g->save_flag |= GS_REMOVE; //But set it to be removed, in case it is not needed for long.
+	inter_guild_save_flag(g, GS_REMOVE); //But set it to be removed, in case it is not needed for long.
 
 	if (charserv_config.save_log)
 		ShowInfo("Guild loaded (%d - %s)\n", guild_id, g->name);
@@ -750,7 +805,7 @@ int inter_guild_CharOffline(uint32 char_id, int guild_id)
 
 	// Remove guild from memory if no players online
 	if( online_count == 0 )
-		g->save_flag |= GS_REMOVE;
+		inter_guild_save_flag(g, GS_REMOVE);
 
 	return 1;
 }
@@ -770,7 +825,7 @@ int inter_guild_sql_init(void)
 	}
 
 	add_timer_func_list(guild_save_timer, "guild_save_timer");
-	add_timer(gettick() + 10000, guild_save_timer, 0, 0);
+	add_timer_interval(gettick() + GUILD_SAVE_STEP, guild_save_timer, 0, 0, GUILD_SAVE_STEP);
 	return 0;
 }
 
@@ -790,6 +845,8 @@ int guild_db_final(DBKey key, DBData *data, va_list ap)
 void inter_guild_sql_final(void)
 {
 	guild_db_->destroy(guild_db_, guild_db_final);
+	guild_save_queue.clear();
+	guild_save_queued.clear();
 	db_destroy(castle_db);
 	return;
 }
@@ -905,7 +962,7 @@ int guild_calcinfo(struct guild *g)
 	// Check if guild stats has change
 	if(g->max_member != before.max_member || g->guild_lv != before.guild_lv || g->skill_point != before.skill_point	)
 	{
-		g->save_flag |= GS_LEVEL;
+		inter_guild_save_flag(g, GS_LEVEL);
 		mapif_guild_info(-1,g);
 		return 1;
 	}
@@ -1281,7 +1338,7 @@ int mapif_parse_GuildAddMember(int fd,int guild_id,struct guild_member *m)
 			if (!guild_calcinfo(g)) //Send members if it was not invoked.
 				mapif_guild_info(-1,g);
 
-			g->save_flag |= GS_MEMBER;
+			inter_guild_save_flag(g, GS_MEMBER);
 			if (g->save_flag&GS_REMOVE)
 				g->save_flag&=~GS_REMOVE;
 			return 0;
@@ -1345,7 +1402,7 @@ int mapif_parse_GuildLeave(int fd, int guild_id, uint32 account_id, uint32 char_
 		//Update member info.
 		if (!guild_calcinfo(g))
 			mapif_guild_info(fd,g);
-		g->save_flag |= GS_EXPULSION;
+		inter_guild_save_flag(g, GS_EXPULSION);
 	}
 
 	return 0;
@@ -1396,11 +1453,11 @@ int mapif_parse_GuildChangeMemberInfoShort(int fd,int guild_id,uint32 account_id
 	{
 		g->average_lv = sum / c;
 		if( g->connect_member != prev_count || g->average_lv != prev_alv )
-			g->save_flag |= GS_CONNECT;
+			inter_guild_save_flag(g, GS_CONNECT);
 		if( g->save_flag & GS_REMOVE )
 			g->save_flag &= ~GS_REMOVE;
 	}
-	g->save_flag |= GS_MEMBER; //Update guild member data
+	inter_guild_save_flag(g, GS_MEMBER); //Update guild member data
 	return 0;
 }
 
@@ -1478,7 +1535,7 @@ int mapif_parse_GuildBasicInfoChange(int fd,int guild_id,int type,const char *da
 				g->guild_lv += data_value;
 
 			mapif_guild_info(-1, g);
-			g->save_flag |= GS_LEVEL;
+			inter_guild_save_flag(g, GS_LEVEL);
 			return 0;
 		default:
 			ShowError("int_guild: GuildBasicInfoChange: Unknown type %d\n",type);
@@ -1529,7 +1586,7 @@ int mapif_parse_GuildMemberInfoChange(int fd,int guild_id,uint32 account_id,uint
 			g->member[i].position=*((short *)data);
 			g->member[i].modified = GS_MEMBER_MODIFIED;
 			mapif_guild_memberinfochanged(guild_id,account_id,char_id,type,data,len);
-			g->save_flag |= GS_MEMBER;
+			inter_guild_save_flag(g, GS_MEMBER);
 			break;
 		  }
 		case GMI_EXP:
@@ -1553,10 +1610,10 @@ int mapif_parse_GuildMemberInfoChange(int fd,int guild_id,uint32 account_id,uint
 
 				guild_calcinfo(g);
 				mapif_guild_basicinfochanged(guild_id,GBI_EXP,&g->exp,sizeof(g->exp));
-				g->save_flag |= GS_LEVEL;
+				inter_guild_save_flag(g, GS_LEVEL);
 			}
 			mapif_guild_memberinfochanged(guild_id,account_id,char_id,type,data,len);
-			g->save_flag |= GS_MEMBER;
+			inter_guild_save_flag(g, GS_MEMBER);
 			break;
 		}
 		case GMI_HAIR:
@@ -1564,7 +1621,7 @@ int mapif_parse_GuildMemberInfoChange(int fd,int guild_id,uint32 account_id,uint
 			g->member[i].hair=*((short *)data);
 			g->member[i].modified = GS_MEMBER_MODIFIED;
 			mapif_guild_memberinfochanged(guild_id,account_id,char_id,type,data,len);
-			g->save_flag |= GS_MEMBER; //Save new data.
+			inter_guild_save_flag(g, GS_MEMBER); //Save new data.
 			break;
 		}
 		case GMI_HAIR_COLOR:
@@ -1572,7 +1629,7 @@ int mapif_parse_GuildMemberInfoChange(int fd,int guild_id,uint32 account_id,uint
 			g->member[i].hair_color=*((short *)data);
 			g->member[i].modified = GS_MEMBER_MODIFIED;
 			mapif_guild_memberinfochanged(guild_id,account_id,char_id,type,data,len);
-			g->save_flag |= GS_MEMBER; //Save new data.
+			inter_guild_save_flag(g, GS_MEMBER); //Save new data.
 			break;
 		}
 		case GMI_GENDER:
@@ -1580,7 +1637,7 @@ int mapif_parse_GuildMemberInfoChange(int fd,int guild_id,uint32 account_id,uint
 			g->member[i].gender=*((short *)data);
 			g->member[i].modified = GS_MEMBER_MODIFIED;
 			mapif_guild_memberinfochanged(guild_id,account_id,char_id,type,data,len);
-			g->save_flag |= GS_MEMBER; //Save new data.
+			inter_guild_save_flag(g, GS_MEMBER); //Save new data.
 			break;
 		}
 		case GMI_CLASS:
@@ -1588,7 +1645,7 @@ int mapif_parse_GuildMemberInfoChange(int fd,int guild_id,uint32 account_id,uint
 			g->member[i].class_=*((short *)data);
 			g->member[i].modified = GS_MEMBER_MODIFIED;
 			mapif_guild_memberinfochanged(guild_id,account_id,char_id,type,data,len);
-			g->save_flag |= GS_MEMBER; //Save new data.
+			inter_guild_save_flag(g, GS_MEMBER); //Save new data.
 			break;
 		}
 		case GMI_LEVEL:
@@ -1596,7 +1653,7 @@ int mapif_parse_GuildMemberInfoChange(int fd,int guild_id,uint32 account_id,uint
 			g->member[i].lv=*((short *)data);
 			g->member[i].modified = GS_MEMBER_MODIFIED;
 			mapif_guild_memberinfochanged(guild_id,account_id,char_id,type,data,len);
-			g->save_flag |= GS_MEMBER; //Save new data.
+			inter_guild_save_flag(g, GS_MEMBER); //Save new data.
 			break;
 		}
 		default:
@@ -1660,7 +1717,7 @@ int mapif_parse_GuildPosition(int fd,int guild_id,int idx,struct guild_position
 	memcpy(&g->position[idx],p,sizeof(struct guild_position));
 	mapif_guild_position(g,idx);
 	g->position[idx].modified = GS_POSITION_MODIFIED;
-	g->save_flag |= GS_POSITION; // Change guild_position
+	inter_guild_save_flag(g, GS_POSITION); // Change guild_position
 	return 0;
 }
 
@@ -1681,7 +1738,7 @@ int mapif_parse_GuildSkillUp(int fd,int guild_id,uint16 skill_id,uint32 account_
 		if (!guild_calcinfo(g))
 			mapif_guild_info(-1,g);
 		mapif_guild_skillupack(guild_id,skill_id,account_id);
-		g->save_flag |= (GS_LEVEL|GS_SKILL); // Change guild & guild_skill
+		inter_guild_save_flag(g, GS_LEVEL|GS_SKILL); // Change guild & guild_skill
 		if (skill_id == GD_GUILD_STORAGE)
 			inter_guild_tosql(g, g->save_flag); // Force save for GD_GUILD_STORAGE
 	}
@@ -1702,7 +1759,7 @@ int mapif_parse_GuildDeleteAlliance(struct guild *g, int guild_id, uint32 accoun
 	g->alliance[i].guild_id=0;
 
 	mapif_guild_alliance(g->guild_id,guild_id,account_id1,account_id2,flag,g->name,name);
-	g->save_flag |= GS_ALLIANCE;
+	inter_guild_save_flag(g, GS_ALLIANCE);
 	return 0;
 }
 
@@ -1761,8 +1818,8 @@ int mapif_parse_GuildAlliance(int fd,int guild_id1,int guild_id2,uint32 account_
 	mapif_guild_alliance(guild_id1,guild_id2,account_id1,account_id2,flag,g[0]->name,g[1]->name);
 
 	// Mark the two guild to be saved
-	g[0]->save_flag |= GS_ALLIANCE;
-	g[1]->save_flag |= GS_ALLIANCE;
+	inter_guild_save_flag(g[0], GS_ALLIANCE);
+	inter_guild_save_flag(g[1], GS_ALLIANCE);
 	return 1;
 }
 
@@ -1777,7 +1834,7 @@ int mapif_parse_GuildNotice(int fd,int guild_id,const char *mes1,const char *mes
 
 	memcpy(g->mes1,mes1,MAX_GUILDMES1);
 	memcpy(g->mes2,mes2,MAX_GUILDMES2);
-	g->save_flag |= GS_MES;	//Change mes of guild
+	inter_guild_save_flag(g, GS_MES);	//Change mes of guild
 	inter_guild_tosql(g, g->save_flag);
 	return mapif_guild_notice(g);
 }
@@ -1796,7 +1853,7 @@ int mapif_parse_GuildEmblem(int fd,int len,int guild_id,int dummy,const char *da
 	memcpy(g->emblem_data,data,len);
 	g->emblem_len=len;
 	g->emblem_id++;
-	g->save_flag |= GS_EMBLEM;	//Change guild
+	inter_guild_save_flag(g, GS_EMBLEM);	//Change guild
 	return mapif_guild_emblem(g);
 }
 
@@ -1880,7 +1937,7 @@ int mapif_parse_GuildMasterChange(int fd, int guild_id, const char* name, int le
 		g->master[len] = '\0';
 
 	ShowInfo("int_guild: Guildmaster Changed to %s (Guild %d - %s)\n",g->master, guild_id, g->name);
-	g->save_flag |= (GS_BASIC|GS_MEMBER); //Save main data and member data.
+	inter_guild_save_flag(g, GS_BASIC|GS_MEMBER); //Save main data and member data.
 	return mapif_guild_master_changed(g, g->member[0].account_id, g->member[0].char_id, g->last_leader_change);
 }
 
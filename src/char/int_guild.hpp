@@ -36,5 +36,7 @@ int inter_guild_charname_changed(int guild_id,uint32 account_id, uint32 char_id,
 int inter_guild_CharOnline(uint32 char_id, int guild_id);
 int inter_guild_CharOffline(uint32 char_id, int guild_id);
 uint16 inter_guild_storagemax(int guild_id);
+void inter_guild_save_flag(struct guild *g, int flag);
+void inter_guild_save_report(void);
 
 #endif /* INT_GUILD_HPP */
@@ -550,32 +550,38 @@ bool mapif_parse_StorageLoad(int fd) {
  * @param fd
  */
 bool mapif_parse_StorageSave(int fd) {
-	int aid, cid, type;
+	int aid, cid, type, stor_size, errors = 0;
 	struct s_storage stor;
 
 	RFIFOHEAD(fd);
 	type = RFIFOB(fd, 4);
 	aid = RFIFOL(fd, 5);
 	cid = RFIFOL(fd, 9);
+	stor_size = RFIFOW(fd, 2) - 13; // only the slots used by the storage type are sent
+
+	if( stor_size < (int)offsetof(struct s_storage, u) || stor_size > (int)sizeof(struct s_storage) ){
+		ShowError( "Invalid storage save size %d (AID: %d, type: %d)\n", stor_size, aid, type );
+		return false;
+	}
 	
 	memset(&stor, 0, sizeof(struct s_storage));
-	memcpy(&stor, RFIFOP(fd, 13), sizeof(struct s_storage));
+	memcpy(&stor, RFIFOP(fd, 13), stor_size);
 
 	//ShowInfo("Saving storage data for AID=%d.\n", aid);
 	switch(type){
-		case TABLE_INVENTORY:	inventory_tosql(cid, &stor); break;
+		case TABLE_INVENTORY:	errors = inventory_tosql(cid, &stor); break;
 		case TABLE_STORAGE:
 			if( !interServerDb.exists( stor.stor_id ) ){
 				ShowError( "Invalid storage with id %d\n", stor.stor_id );
 				return false;
 			}
 
-			storage_tosql(aid, &stor);
+			errors = storage_tosql(aid, &stor);
 			break;
-		case TABLE_CART:	cart_tosql(cid, &stor); break;
+		case TABLE_CART:	errors = cart_tosql(cid, &stor); break;
 		default: return false;
 	}
-	mapif_storage_saved(fd, aid, cid, true, type, stor.stor_id);
+	mapif_storage_saved(fd, aid, cid, errors == 0, type, stor.stor_id);
 	return false;
 }
 
@@ -367,6 +367,7 @@ int main (int argc, char **argv)
 	while (runflag != CORE_ST_STOP) { 
 		t_tick next = do_timer(gettick_nocache());
 		do_sockets(next);
+		tick_arena_reset();
 	}
 
 	do_final();
@@ -28,13 +28,18 @@
  *    destroyed so memory will usually only be recovered near the end.       *
  *  - Always wastes space for entries smaller than a pointer.                *
  *                                                                           *
- *  WARNING: The system is not thread-safe at the moment.                    *
+ *  Entries can be freed from any thread. Entries freed by a thread other    *
+ *  than the one that created the cache are pushed to a lock-free return     *
+ *  list and are reused by the owning thread once its reuse list is empty.   *
+ *  WARNING: Allocating entries and creating or destroying managers is only  *
+ *  safe from the thread that created the cache.                             *
  *                                                                           *
  *  HISTORY:                                                                 *
  *    0.1 - Initial version                                                  *
  *    1.0 - ERS Rework                                                       *
+ *    1.1 - Lock-free return path for entries freed by other threads         *
  *                                                                           *
- * @version 1.0 - ERS Rework                                                 *
+ * @version 1.1 - Lock-free return path                                      *
  * @author GreenBox @ rAthena Project                                        *
  * @encoding US-ASCII                                                        *
  * @see common#ers.hpp                                                         *
@@ -42,6 +47,9 @@
 
 #include "ers.hpp"
 
+#include <atomic>
+#include <thread>
+
 #include <stdlib.h>
 #include <string.h>
 
@@ -72,6 +80,12 @@ typedef struct ers_cache
 	// Reuse linked list
 	struct ers_list *ReuseList;
 
+	// Entries freed by other threads, waiting to be moved to ReuseList by the owner
+	std::atomic<struct ers_list *> RemoteList;
+
+	// Thread that created the cache, the only one allowed to allocate from it
+	std::thread::id Owner;
+
 	// Memory blocks array
 	unsigned char **Blocks;
 
@@ -113,6 +127,9 @@ struct ers_instance_t {
 	// Count of objects in use, used for detecting memory leaks
 	unsigned int Count;
 
+	// Count of objects freed by other threads, to be subtracted from Count
+	std::atomic<unsigned int> RemoteCount;
+
 	struct ers_instance_t *Next, *Prev;
 };
 
@@ -135,6 +152,8 @@ static ers_cache_t *ers_find_cache(unsigned int size, enum ERSOptions Options) {
 	cache->ObjectSize = size;
 	cache->ReferenceCount = 0;
 	cache->ReuseList = NULL;
+	cache->RemoteList.store(NULL, std::memory_order_relaxed);
+	cache->Owner = std::this_thread::get_id();
 	cache->Blocks = NULL;
 	cache->Free = 0;
 	cache->Used = 0;
@@ -178,6 +197,32 @@ static void ers_free_cache(ers_cache_t *cache, bool remove)
 	aFree(cache);
 }
 
+/**
+ * Moves the entries freed by other threads to the reuse list.
+ * Must only be called by the owner of the cache.
+ * @param cache Cache to collect the entries of
+ * @return true if any entries were collected
+ */
+static bool ers_collect_remote(ers_cache_t *cache)
+{
+	// Taking the whole list at once means there is no ABA problem with concurrent pushes
+	struct ers_list *list = cache->RemoteList.exchange(NULL, std::memory_order_acquire);
+	struct ers_list *tail;
+	unsigned int count = 1;
+
+	if (list == NULL)
+		return false;
+
+	for (tail = list; tail->Next != NULL; tail = tail->Next)
+		count++;
+
+	tail->Next = cache->ReuseList;
+	cache->ReuseList = list;
+	cache->UsedObjs -= count;
+
+	return true;
+}
+
 static void *ers_obj_alloc_entry(ERS *self)
 {
 	struct ers_instance_t *instance = (struct ers_instance_t *)self;
@@ -188,7 +233,7 @@ static void *ers_obj_alloc_entry(ERS *self)
 		return NULL;
 	}
 
-	if (instance->Cache->ReuseList != NULL) {
+	if (instance->Cache->ReuseList != NULL || ers_collect_remote(instance->Cache)) {
 		ret = (void *)((unsigned char *)instance->Cache->ReuseList + sizeof(struct ers_list));
 		instance->Cache->ReuseList = instance->Cache->ReuseList->Next;
 	} else if (instance->Cache->Free > 0) {
@@ -229,6 +274,18 @@ static void ers_obj_free_entry(ERS *self, void *entry)
 	if( instance->Cache->Options & ERS_OPT_CLEAN )
 		memset((unsigned char*)reuse + sizeof(struct ers_list), 0, instance->Cache->ObjectSize - sizeof(struct ers_list));
 
+	if (std::this_thread::get_id() != instance->Cache->Owner) {
+		// Hand the entry back to the owner without touching its reuse list
+		struct ers_list *head = instance->Cache->RemoteList.load(std::memory_order_relaxed);
+
+		do {
+			reuse->Next = head;
+		} while (!instance->Cache->RemoteList.compare_exchange_weak(head, reuse, std::memory_order_release, std::memory_order_relaxed));
+
+		instance->RemoteCount.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
 	reuse->Next = instance->Cache->ReuseList;
 	instance->Cache->ReuseList = reuse;
 	instance->Count--;
@@ -256,6 +313,8 @@ static void ers_obj_destroy(ERS *self)
 		return;
 	}
 
+	instance->Count -= instance->RemoteCount.exchange(0, std::memory_order_relaxed);
+
 	if (instance->Count > 0)
 		if (!(instance->Options & ERS_OPT_CLEAR))
 			ShowWarning("Memory leak detected at ERS '%s', %d objects not freed.\n", instance->Name, instance->Count);
@@ -325,6 +384,7 @@ ERS *ers_new(uint32 size, const char *name, enum ERSOptions options)
 	}
 
 	instance->Count = 0;
+	instance->RemoteCount.store(0, std::memory_order_relaxed);
 
 	return &instance->VTable;
 }
@@ -334,6 +394,7 @@ void ers_report(void) {
 	unsigned int cache_c = 0, blocks_u = 0, blocks_a = 0, memory_b = 0, memory_t = 0;
 
 	for (cache = CacheList; cache; cache = cache->Next) {
+		ers_collect_remote(cache);
 		cache_c++;
 		ShowMessage(CL_BOLD"[ERS Cache of size '" CL_NORMAL "" CL_WHITE "%u" CL_NORMAL "" CL_BOLD "' report]\n" CL_NORMAL, cache->ObjectSize);
 		ShowMessage("\tinstances          : %u\n", cache->ReferenceCount);
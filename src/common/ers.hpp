@@ -28,7 +28,10 @@
  *    destroyed so memory will usually only be recovered near the end.       *
  *  - Always wastes space for entries smaller than a pointer.                *
  *                                                                           *
- *  WARNING: The system is not thread-safe at the moment.                    *
+ *  Entries can be freed from any thread, they flow back to the thread that  *
+ *  created the cache through a lock-free list.                              *
+ *  WARNING: Allocating entries and creating or destroying managers is only  *
+ *  safe from the thread that created the cache.                             *
  *                                                                           *
  *  HISTORY:                                                                 *
  *    0.1 - Initial version                                                  *
@@ -103,6 +106,8 @@ typedef struct eri {
 
 	/**
 	 * Free an entry allocated from this manager.
+	 * Can be called from any thread, entries freed by other threads than the
+	 * owner of the cache are reused once the owner runs out of free entries.
 	 * WARNING: Does not check if the entry was allocated by this manager.
 	 * Freeing such an entry can lead to unexpected behavior.
 	 * @param self Interface of the entry manager
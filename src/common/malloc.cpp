@@ -695,6 +695,166 @@ bool malloc_verify_ptr(void* ptr)
 }
 
 
+/*======================================
+ * Tick Arena
+ *--------------------------------------
+ */
+
+#define TICK_ARENA_CHUNK_SIZE	(64*1024)
+#define TICK_ARENA_ALIGNMENT	16
+#define TICK_ARENA_POISON		0xDD
+
+struct tick_arena_chunk {
+	struct tick_arena_chunk* next;
+	size_t size; // usable bytes
+	size_t used;
+	// data follows, aligned to TICK_ARENA_ALIGNMENT
+};
+
+#define TICK_ARENA_HEADER ( ( sizeof(struct tick_arena_chunk) + TICK_ARENA_ALIGNMENT - 1 ) & ~(size_t)( TICK_ARENA_ALIGNMENT - 1 ) )
+#define tick_arena_data(chunk) ( (unsigned char*)(chunk) + TICK_ARENA_HEADER )
+
+static struct tick_arena_chunk* tick_arena_head = NULL;
+static struct tick_arena_chunk* tick_arena_current = NULL;
+
+static struct {
+	uint64 allocs; // allocations served since startup, each one would have been a malloc/free pair
+	uint64 resets;
+	size_t usage;  // bytes used in the current iteration
+	size_t peak;   // highest usage of a single iteration
+} tick_arena_stats;
+
+/// Allocates memory that stays valid until the next tick_arena_reset.
+void* tick_arena_alloc(size_t size, const char *file, int line, const char *func)
+{
+	struct tick_arena_chunk* chunk;
+	void* ret;
+
+	size = ( size + TICK_ARENA_ALIGNMENT - 1 ) & ~(size_t)( TICK_ARENA_ALIGNMENT - 1 );
+	if( size == 0 )
+		size = TICK_ARENA_ALIGNMENT;
+
+	// use the first chunk with enough space, all chunks after the current one are empty
+	for( chunk = tick_arena_current; chunk != NULL && chunk->size - chunk->used < size; chunk = chunk->next );
+
+	if( chunk != NULL )
+		tick_arena_current = chunk;
+	else{
+		size_t chunk_size = max( size, (size_t)TICK_ARENA_CHUNK_SIZE );
+
+		chunk = (struct tick_arena_chunk*)MALLOC( TICK_ARENA_HEADER + chunk_size, file, line, func );
+		if( chunk == NULL ){
+			ShowFatalError("%s:%d: in func %s: tick_arena_alloc error out of memory!\n", file, line, func);
+			exit(EXIT_FAILURE);
+		}
+		chunk->size = chunk_size;
+		chunk->used = 0;
+
+		// insert after the current chunk, so the empty chunks behind it stay in order
+		if( tick_arena_current == NULL ){
+			chunk->next = tick_arena_head;
+			tick_arena_head = chunk;
+		}else{
+			chunk->next = tick_arena_current->next;
+			tick_arena_current->next = chunk;
+		}
+		tick_arena_current = chunk;
+	}
+
+	ret = tick_arena_data(chunk) + chunk->used;
+	chunk->used += size;
+
+	tick_arena_stats.allocs++;
+	tick_arena_stats.usage += size;
+
+	return ret;
+}
+
+/// Allocates zeroed memory that stays valid until the next tick_arena_reset.
+void* tick_arena_calloc(size_t num, size_t size, const char *file, int line, const char *func)
+{
+	void* ret = tick_arena_alloc( num * size, file, line, func );
+
+	memset( ret, 0, num * size );
+	return ret;
+}
+
+/// Returns true if the pointer points into memory of the tick arena.
+/// Can be used to verify that arena memory is not stored in long living structures.
+bool tick_arena_owns(const void* ptr)
+{
+	struct tick_arena_chunk* chunk;
+
+	for( chunk = tick_arena_head; chunk != NULL; chunk = chunk->next ){
+		if( (const unsigned char*)ptr >= tick_arena_data(chunk) && (const unsigned char*)ptr < tick_arena_data(chunk) + chunk->size )
+			return true;
+	}
+
+	return false;
+}
+
+/// Releases all memory allocated from the tick arena.
+/// Called by the core after each server loop iteration.
+void tick_arena_reset(void)
+{
+	struct tick_arena_chunk* chunk = tick_arena_head;
+	struct tick_arena_chunk* prev = NULL;
+
+	while( chunk != NULL ){
+		struct tick_arena_chunk* next = chunk->next;
+
+		if( chunk->size > TICK_ARENA_CHUNK_SIZE ){
+			// oversized chunks are only kept for the iteration that needed them
+			if( prev != NULL )
+				prev->next = next;
+			else
+				tick_arena_head = next;
+			FREE( chunk, __FILE__, __LINE__, __func__ );
+		}else{
+#ifdef DEBUG_TICK_ARENA
+			memset( tick_arena_data(chunk), TICK_ARENA_POISON, chunk->used );
+#endif
+			chunk->used = 0;
+			prev = chunk;
+		}
+
+		chunk = next;
+	}
+
+	tick_arena_current = tick_arena_head;
+	tick_arena_stats.peak = max( tick_arena_stats.peak, tick_arena_stats.usage );
+	tick_arena_stats.usage = 0;
+	tick_arena_stats.resets++;
+}
+
+/// Prints the usage of the tick arena.
+void tick_arena_report(void)
+{
+	struct tick_arena_chunk* chunk;
+	unsigned int chunks = 0;
+	size_t size = 0;
+
+	for( chunk = tick_arena_head; chunk != NULL; chunk = chunk->next ){
+		chunks++;
+		size += chunk->size;
+	}
+
+	ShowInfo("tick_arena: '" CL_WHITE "%" PRIu64 CL_NORMAL "' allocations over '" CL_WHITE "%" PRIu64 CL_NORMAL "' iterations\n", tick_arena_stats.allocs, tick_arena_stats.resets);
+	ShowInfo("tick_arena: '" CL_WHITE "%u" CL_NORMAL "' chunks, consuming '" CL_WHITE "%.2f MB" CL_NORMAL "', peak usage '" CL_WHITE "%.2f KB" CL_NORMAL "'\n", chunks, (double)size/1024/1024, (double)tick_arena_stats.peak/1024);
+}
+
+static void tick_arena_final(void)
+{
+	while( tick_arena_head != NULL ){
+		struct tick_arena_chunk* next = tick_arena_head->next;
+
+		FREE( tick_arena_head, __FILE__, __LINE__, __func__ );
+		tick_arena_head = next;
+	}
+
+	tick_arena_current = NULL;
+}
+
 size_t malloc_usage (void)
 {
 #ifdef USE_MEMMGR
@@ -706,6 +866,7 @@ size_t malloc_usage (void)
 
 void malloc_final (void)
 {
+	tick_arena_final();
 #ifdef USE_MEMMGR
 	memmgr_final ();
 #endif
@@ -81,6 +81,27 @@
 #define CREATE(result, type, number) (result) = (type *) aCalloc ((number), sizeof(type))
 #define RECREATE(result, type, number) (result) = (type *) aRealloc ((result), sizeof(type) * (number))
 
+/////////////// Tick Arena /////////////////
+// Bump allocator for memory that dies within the current server loop iteration
+// (timer callbacks and packet handlers). Everything allocated from it is released
+// at once by tick_arena_reset after do_sockets, so it must never be freed manually
+// and pointers to it must never be kept beyond the current callback.
+// With DEBUG_TICK_ARENA released memory is poisoned to expose such escapes.
+
+#if defined(DEBUG) && !defined(DEBUG_TICK_ARENA)
+#define DEBUG_TICK_ARENA
+#endif
+
+#define aTickMalloc(n)		tick_arena_alloc((n),ALC_MARK)
+#define aTickCalloc(m,n)	tick_arena_calloc((m),(n),ALC_MARK)
+#define TICK_CREATE(result, type, number) (result) = (type *) aTickCalloc ((number), sizeof(type))
+
+void* tick_arena_alloc (size_t size, const char *file, int line, const char *func);
+void* tick_arena_calloc (size_t num, size_t size, const char *file, int line, const char *func);
+bool tick_arena_owns (const void* ptr);
+void tick_arena_reset (void);
+void tick_arena_report (void);
+
 ////////////////////////////////////////////////
 
 void malloc_memory_check(void);
@@ -17,6 +17,13 @@ void rnd_init( void ){
 	uint32_distribution = std::uniform_int_distribution<uint32>( 0, UINT32_MAX );
 }
 
+/// Reseeds the random number generator with a fixed seed, making the following numbers reproducible
+void rnd_seed( uint32 seed ){
+	generator.seed( seed );
+	int31_distribution.reset();
+	uint32_distribution.reset();
+}
+
 /// Generates a random number in the interval [0, SINT32_MAX]
 int32 rnd( void ){
 	return int31_distribution( generator );
@@ -239,6 +239,10 @@ time_t stall_time = 60;
 uint32 addr_[16];   // ip addresses of local host (host byte order)
 int naddr_ = 0;   // # of ip addresses
 
+static bool packet_capture = false; // record the data received from clients
+static FILE* packet_capture_fp = NULL;
+static t_tick packet_capture_start;
+
 
 // (^~_~^) Gepard Shield Start
 
@@ -741,6 +745,49 @@ void set_eof(int fd)
 	}
 }
 
+/// Opens the packet capture file of this server.
+static void packet_capture_init(void)
+{
+	const char* name;
+	char filename[64];
+	uint32 header[2] = { PACKET_CAPTURE_MAGIC, PACKET_CAPTURE_VERSION };
+
+	if( !packet_capture )
+		return;
+
+	switch( SERVER_TYPE ) {
+		case ATHENA_SERVER_LOGIN: name = "login"; break;
+		case ATHENA_SERVER_CHAR: name = "char"; break;
+		case ATHENA_SERVER_MAP: name = "map"; break;
+		default: name = "server"; break;
+	}
+
+	safesnprintf(filename, sizeof(filename), "log/packet_capture_%s.bin", name);
+
+	if( (packet_capture_fp = fopen(filename, "wb")) == NULL ) {
+		ShowError("packet_capture_init: Failed to open '%s' for writing.\n", filename);
+		return;
+	}
+
+	fwrite(header, sizeof(header), 1, packet_capture_fp);
+	packet_capture_start = gettick();
+	ShowNotice("Capturing the data received from clients into '" CL_WHITE "%s" CL_RESET "'.\n", filename);
+}
+
+/// Appends a record to the packet capture file.
+static void packet_capture_write(int fd, const unsigned char* data, size_t length)
+{
+	struct s_packet_capture_record record;
+
+	record.tick = (uint32)DIFF_TICK(gettick(), packet_capture_start);
+	record.session = (uint32)fd;
+	record.length = (uint32)length;
+
+	fwrite(&record, sizeof(record), 1, packet_capture_fp);
+	if( length > 0 )
+		fwrite(data, length, 1, packet_capture_fp);
+}
+
 int recv_to_fifo(int fd)
 {
 	int len;
@@ -765,6 +812,9 @@ int recv_to_fifo(int fd)
 		return 0;
 	}
 
+	if( packet_capture_fp != NULL && !session[fd]->flag.server )
+		packet_capture_write(fd, session[fd]->rdata + session[fd]->rdata_size, len);
+
 	session[fd]->rdata_size += len;
 	session[fd]->rdata_tick = last_tick;
 #ifdef SHOW_SERVER_STATS
@@ -1728,6 +1778,8 @@ int socket_config_read(const char* cfgName)
 			ddos_autoreset = atoi(w2);
 		else if (!strcmpi(w1,"debug"))
 			access_debug = config_switch(w2);
+		else if (!strcmpi(w1,"packet_capture"))
+			packet_capture = config_switch(w2) != 0;
 #ifdef SOCKET_EPOLL
 		else if( !strcmpi( w1, "epoll_maxevents" ) ){
 			epoll_maxevents = atoi(w2);
@@ -1776,6 +1828,11 @@ void socket_final(void)
 		if(session[i])
 			do_close(i);
 
+	if( packet_capture_fp != NULL ) {
+		fclose(packet_capture_fp);
+		packet_capture_fp = NULL;
+	}
+
 	// session[0]
 	aFree(session[0]->rdata);
 	aFree(session[0]->wdata);
@@ -1819,6 +1876,9 @@ void do_close(int fd)
 	epoll_ctl( epfd, EPOLL_CTL_DEL, fd, &epevent ); // removing the socket from epoll when it's being closed is not required but recommended
 #endif
 
+	if( packet_capture_fp != NULL && session[fd] && session[fd]->func_recv == recv_to_fifo && !session[fd]->flag.server )
+		packet_capture_write(fd, NULL, 0); // end of the session
+
 	sShutdown(fd, SHUT_RDWR); // Disallow further reads/writes
 	sClose(fd); // We don't really care if these closing functions return an error, we are just shutting down and not reusing this socket.
 	if (session[fd]) delete_session(fd);
@@ -1987,6 +2047,7 @@ void socket_init(void)
 #endif
 
 	socket_config_read(SOCKET_CONF_FILENAME);
+	packet_capture_init();
 
 // (^~_~^) Gepard Shield Start
 
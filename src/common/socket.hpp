@@ -207,6 +207,20 @@ void gepard_process_sc_packet(int fd, struct socket_data* s, size_t packet_size)
 #define TOL(n) ((uint32)((n)&UINT32_MAX))
 
 
+// Packet capture file format (see packet_capture in conf/packet_athena.conf)
+// The file starts with PACKET_CAPTURE_MAGIC and PACKET_CAPTURE_VERSION as uint32,
+// followed by records in host byte order.
+#define PACKET_CAPTURE_MAGIC 0x43504152 // "RAPC"
+#define PACKET_CAPTURE_VERSION 1
+
+/// Header of a record in a packet capture file, followed by 'length' bytes of received data.
+/// A record with length 0 marks the end of the session.
+struct s_packet_capture_record {
+	uint32 tick; ///< Milliseconds since the start of the capture
+	uint32 session; ///< Fd of the session, reused by new sessions after the end of the session
+	uint32 length;
+};
+
 // Struct declaration
 typedef int (*RecvFunc)(int fd);
 typedef int (*SendFunc)(int fd);
@@ -9,6 +9,7 @@
 
 #include <mysql.h>
 #include <stdlib.h>// strtoul
+#include <string>
 
 #include "cbasetypes.hpp"
 #include "malloc.hpp"
@@ -988,6 +989,136 @@ void SqlStmt_Free(SqlStmt* self)
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Background thread connections
+///////////////////////////////////////////////////////////////////////////////
+
+
+
+/// Sql handle for a background thread, allocated with new (the memory manager is not thread safe).
+/// The login data is kept to reconnect.
+struct SqlThread
+{
+	MYSQL handle;
+	std::string user, passwd, host, db, encoding;
+	uint16 port;
+	bool connected;
+};
+
+
+
+/// Connects or reconnects the handle.
+/// @private
+static bool SqlThread_P_Connect(SqlThread* self, char* out_error, size_t error_len)
+{
+	if( self->connected )
+	{
+		mysql_close(&self->handle);
+		self->connected = false;
+	}
+
+	if( !mysql_init(&self->handle) )
+	{
+		safestrncpy(out_error, "mysql_init failed", error_len);
+		return false;
+	}
+
+	if( !mysql_real_connect(&self->handle, self->host.c_str(), self->user.c_str(), self->passwd.c_str(), self->db.c_str(), (unsigned int)self->port, NULL/*unix_socket*/, 0/*clientflag*/) )
+	{
+		safestrncpy(out_error, mysql_error(&self->handle), error_len);
+		mysql_close(&self->handle);
+		return false;
+	}
+	self->connected = true;
+
+	if( !self->encoding.empty() )
+	{
+		std::string query = "SET NAMES " + self->encoding;
+
+		if( mysql_real_query(&self->handle, query.c_str(), (unsigned long)query.length()) )
+		{
+			safestrncpy(out_error, mysql_error(&self->handle), error_len);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+
+
+/// Connects to the database from the calling thread.
+struct SqlThread* SqlThread_Connect(const char* user, const char* passwd, const char* host, uint16 port, const char* db, const char* encoding, char* out_error, size_t error_len)
+{
+	SqlThread* self = new SqlThread();
+
+	mysql_thread_init();
+
+	self->user = user;
+	self->passwd = passwd;
+	self->host = host;
+	self->port = port;
+	self->db = db;
+	self->encoding = encoding ? encoding : "";
+	self->connected = false;
+
+	if( !SqlThread_P_Connect(self, out_error, error_len) )
+	{
+		SqlThread_Free(self);
+		return NULL;
+	}
+
+	return self;
+}
+
+
+
+/// Executes a query that returns no result.
+int SqlThread_QueryStr(SqlThread* self, const char* query, size_t query_len, char* out_error, size_t error_len)
+{
+	if( self == NULL )
+		return SQL_ERROR;
+
+	for( int attempt = 0; attempt < 2; attempt++ )
+	{
+		if( !self->connected && !SqlThread_P_Connect(self, out_error, error_len) )
+			return SQL_ERROR;
+
+		if( mysql_real_query(&self->handle, query, (unsigned long)query_len) == 0 )
+			return SQL_SUCCESS;
+
+		safestrncpy(out_error, mysql_error(&self->handle), error_len);
+
+		switch( mysql_errno(&self->handle) )
+		{
+			case 2006:// MySQL server has gone away
+			case 2013:// Lost connection to MySQL server during query
+				mysql_close(&self->handle);
+				self->connected = false;
+				continue;
+		}
+		break;
+	}
+
+	return SQL_ERROR;
+}
+
+
+
+/// Closes a connection returned by SqlThread_Connect.
+void SqlThread_Free(SqlThread* self)
+{
+	if( self )
+	{
+		if( self->connected )
+			mysql_close(&self->handle);
+		delete self;
+		mysql_thread_end();
+	}
+}
+
+
+
 /// Receives MySQL error codes during runtime (not on first-time-connects).
 void ra_mysql_error_handler(unsigned int ecode) {
 	switch( ecode ) {
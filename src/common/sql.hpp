@@ -345,6 +345,39 @@ void SqlStmt_ShowDebug_(SqlStmt* self, const char* debug_file, const unsigned lo
 /// Frees a SqlStmt returned by SqlStmt_Malloc.
 void SqlStmt_Free(SqlStmt* self);
 
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Background thread connections
+///////////////////////////////////////////////////////////////////////////////
+
+/// Connection owned by a thread other than the main thread.
+/// It doesn't use the memory manager, timers or showmsg, so it is safe to use
+/// from a background thread. Errors are returned as text for the main thread
+/// to report. A lost connection is reestablished on the next query.
+struct SqlThread;
+
+
+
+/// Connects to the database from the calling thread.
+/// The encoding is optional.
+///
+/// @return the connection, or NULL with the reason in out_error
+struct SqlThread* SqlThread_Connect(const char* user, const char* passwd, const char* host, uint16 port, const char* db, const char* encoding, char* out_error, size_t error_len);
+
+
+
+/// Executes a query that returns no result (INSERT, UPDATE, ...).
+///
+/// @return SQL_SUCCESS or SQL_ERROR with the reason in out_error
+int SqlThread_QueryStr(SqlThread* self, const char* query, size_t query_len, char* out_error, size_t error_len);
+
+
+
+/// Closes a connection returned by SqlThread_Connect.
+/// Must be called by the thread that connected.
+void SqlThread_Free(SqlThread* self);
+
 void Sql_Init(void);
 
 #endif /* SQL_HPP */
@@ -3,6 +3,10 @@
 
 #include "timer.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
 #include <stdlib.h>
 #include <string.h>
 
@@ -47,6 +51,12 @@ static int free_timer_list_pos = 0;
 // timer heap (binary heap of tid's)
 static BHEAP_VAR(int, timer_heap);
 
+// timers carried over to the next do_timer loop (outside of the heap until the loop ends)
+static std::vector<int> timer_deferred;
+
+// time in ms after which a do_timer loop stops executing background timers (0 = unlimited)
+static t_tick timer_background_budget = 0;
+
 
 // server startup time
 time_t start_time;
@@ -95,6 +105,143 @@ const char* search_timer_func_list(TimerFunc func)
 	return "unknown timer function";
 }
 
+/*----------------------------
+ * 	Timer statistics
+ *----------------------------*/
+static bool timer_stats_active = false;
+static std::unordered_map<TimerFunc, struct s_timer_stats> timer_stats_db;
+
+/// Upper limits (exclusive, in microseconds) of the execution time buckets, the last bucket is unbounded
+static const uint64 timer_stats_buckets[TIMER_STATS_BUCKETS - 1] = { 10, 50, 100, 500, 1000, 2000, 5000, 10000, 20000 };
+
+/// Enables or disables the collection of timer statistics.
+void timer_stats_enable(bool enable)
+{
+	timer_stats_active = enable;
+}
+
+/// Returns whether timer statistics are being collected.
+bool timer_stats_enabled(void)
+{
+	return timer_stats_active;
+}
+
+/// Clears all collected timer statistics.
+void timer_stats_reset(void)
+{
+	timer_stats_db.clear();
+}
+
+/// Returns the upper limit of an execution time bucket in microseconds, or 0 for the unbounded last bucket.
+uint64 timer_stats_bucket_limit(int bucket)
+{
+	if( bucket < 0 || bucket >= TIMER_STATS_BUCKETS - 1 )
+		return 0;
+
+	return timer_stats_buckets[bucket];
+}
+
+/// Records a single execution of a timer function.
+/// @param func Executed function
+/// @param late Milliseconds between the scheduled and the actual execution
+/// @param time Execution time in microseconds
+static void timer_stats_record(TimerFunc func, t_tick late, uint64 time)
+{
+	struct s_timer_stats& stats = timer_stats_db[func];
+	int bucket;
+
+	stats.calls++;
+	stats.time += time;
+	stats.time_max = max(stats.time_max, time);
+
+	if( late > 0 ) {
+		stats.late += late;
+		stats.late_max = max(stats.late_max, (uint64)late);
+	}
+
+	ARR_FIND(0, TIMER_STATS_BUCKETS - 1, bucket, time < timer_stats_buckets[bucket]);
+	stats.histogram[bucket]++;
+}
+
+/// Returns the collected statistics of all timer functions, ordered by total execution time.
+std::vector<struct s_timer_stats> timer_stats_get(void)
+{
+	std::vector<struct s_timer_stats> result;
+
+	result.reserve(timer_stats_db.size());
+
+	for( const auto& it : timer_stats_db ) {
+		result.push_back(it.second);
+		result.back().name = search_timer_func_list(it.first);
+	}
+
+	std::sort(result.begin(), result.end(), [](const struct s_timer_stats& a, const struct s_timer_stats& b) -> bool {
+		return a.time > b.time;
+	});
+
+	return result;
+}
+
+/// Prints the collected statistics of all timer functions to the console.
+void timer_stats_report(void)
+{
+	std::vector<struct s_timer_stats> stats = timer_stats_get();
+	uint64 calls = 0, time = 0;
+
+	for( const auto& it : stats ) {
+		ShowMessage(CL_BOLD "[Timer function '" CL_NORMAL CL_WHITE "%s" CL_NORMAL CL_BOLD "' report]\n" CL_NORMAL, it.name);
+		ShowMessage("\tcalls              : %" PRIu64 "\n", it.calls);
+		ShowMessage("\ttime total         : %.2f ms\n", it.time / 1000.);
+		ShowMessage("\ttime avg/max       : %" PRIu64 "/%" PRIu64 " us\n", it.calls ? it.time / it.calls : 0, it.time_max);
+		ShowMessage("\tlate avg/max       : %.2f/%" PRIu64 " ms\n", it.calls ? (double)it.late / it.calls : 0., it.late_max);
+		ShowMessage("\tdeferred           : %" PRIu64 "\n", it.deferred);
+		calls += it.calls;
+		time += it.time;
+	}
+
+	ShowInfo("timer_stats: statistics are '" CL_WHITE "%s" CL_NORMAL "'\n", timer_stats_active ? "enabled" : "disabled");
+	ShowInfo("timer_stats: '" CL_WHITE "%" PRIu64 CL_NORMAL "' calls of '" CL_WHITE "%u" CL_NORMAL "' functions, taking '" CL_WHITE "%.2f ms" CL_NORMAL "'\n", calls, (unsigned int)stats.size(), time / 1000.);
+}
+
+/// Appends the collected statistics of all timer functions as CSV rows to a file.
+/// @param filename File to append to
+/// @param reset Whether to clear the statistics afterwards, so each dump covers the time since the previous one
+/// @return true on success
+bool timer_stats_dump(const char* filename, bool reset)
+{
+	FILE* fp = fopen(filename, "a");
+	int i;
+
+	if( fp == NULL ) {
+		ShowError("timer_stats_dump: Could not open '%s' for writing.\n", filename);
+		return false;
+	}
+
+	// Write the header if the file is new
+	if( ftell(fp) == 0 ) {
+		fprintf(fp, "time,function,calls,total_us,max_us,late_total_ms,late_max_ms,deferred");
+		for( i = 0; i < TIMER_STATS_BUCKETS - 1; i++ )
+			fprintf(fp, ",lt_%" PRIu64 "us", timer_stats_buckets[i]);
+		fprintf(fp, ",ge_%" PRIu64 "us\n", timer_stats_buckets[TIMER_STATS_BUCKETS - 2]);
+	}
+
+	time_t now = time(NULL);
+
+	for( const auto& it : timer_stats_get() ) {
+		fprintf(fp, "%" PRId64 ",%s,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64, (int64)now, it.name, it.calls, it.time, it.time_max, it.late, it.late_max, it.deferred);
+		for( i = 0; i < TIMER_STATS_BUCKETS; i++ )
+			fprintf(fp, ",%" PRIu64, it.histogram[i]);
+		fprintf(fp, "\n");
+	}
+
+	fclose(fp);
+
+	if( reset )
+		timer_stats_reset();
+
+	return true;
+}
+
 /*----------------------------
  * 	Get tick time
  *----------------------------*/
@@ -243,8 +390,9 @@ static int acquire_timer(void)
 }
 
 /// Starts a new timer that is deleted once it expires (single-use).
+/// Background timers may be carried over to later loops when the server is busy, see timer_set_background_budget.
 /// Returns the timer's id.
-int add_timer(t_tick tick, TimerFunc func, int id, intptr_t data)
+int add_timer(t_tick tick, TimerFunc func, int id, intptr_t data, enum e_timer_priority priority)
 {
 	int tid;
 
@@ -255,6 +403,7 @@ int add_timer(t_tick tick, TimerFunc func, int id, intptr_t data)
 	timer_data[tid].data     = data;
 	timer_data[tid].type     = TIMER_ONCE_AUTODEL;
 	timer_data[tid].interval = 1000;
+	timer_data[tid].priority = priority;
 	push_timer_heap(tid);
 
 	return tid;
@@ -262,7 +411,7 @@ int add_timer(t_tick tick, TimerFunc func, int id, intptr_t data)
 
 /// Starts a new timer that automatically restarts itself (infinite loop until manually removed).
 /// Returns the timer's id, or INVALID_TIMER if it fails.
-int add_timer_interval(t_tick tick, TimerFunc func, int id, intptr_t data, int interval)
+int add_timer_interval(t_tick tick, TimerFunc func, int id, intptr_t data, int interval, enum e_timer_priority priority)
 {
 	int tid;
 
@@ -279,6 +428,7 @@ int add_timer_interval(t_tick tick, TimerFunc func, int id, intptr_t data, int i
 	timer_data[tid].data     = data;
 	timer_data[tid].type     = TIMER_INTERVAL;
 	timer_data[tid].interval = interval;
+	timer_data[tid].priority = priority;
 	push_timer_heap(tid);
 
 	return tid;
@@ -325,17 +475,23 @@ t_tick sett_tickimer(int tid, t_tick tick)
 {
 	size_t i;
 
+	if( tick == -1 )
+		tick = 0;// add 1ms to avoid the error value -1
+
 	// search timer position
 	ARR_FIND(0, BHEAP_LENGTH(timer_heap), i, BHEAP_DATA(timer_heap)[i] == tid);
 	if( i == BHEAP_LENGTH(timer_heap) )
 	{
+		if( std::find(timer_deferred.begin(), timer_deferred.end(), tid) != timer_deferred.end() )
+		{// carried over timer, will be pushed back to the heap at the end of the loop
+			timer_data[tid].tick = tick;
+			return tick;
+		}
+
 		ShowError("sett_tickimer: no such timer %d (%p(%s))\n", tid, timer_data[tid].func, search_timer_func_list(timer_data[tid].func));
 		return -1;
 	}
 
-	if( tick == -1 )
-		tick = 0;// add 1ms to avoid the error value -1
-
 	if( timer_data[tid].tick == tick )
 		return tick;// nothing to do, already in propper position
 
@@ -363,15 +519,39 @@ t_tick do_timer(t_tick tick)
 
 		// remove timer
 		BHEAP_POP(timer_heap, DIFFTICK_MINTOPCMP, SWAP);
+
+		// background budget exhausted, carry the timer over unless it is already late for too long
+		if( timer_data[tid].priority == TIMER_PRIORITY_BACKGROUND && timer_background_budget > 0 && diff > -TIMER_MAX_INTERVAL
+			&& DIFF_TICK(gettick_nocache(), tick) >= timer_background_budget )
+		{
+			if( timer_stats_active && timer_data[tid].func )
+				timer_stats_db[timer_data[tid].func].deferred++;
+			timer_deferred.push_back(tid);
+			continue;
+		}
+
 		timer_data[tid].type |= TIMER_REMOVE_HEAP;
 
 		if( timer_data[tid].func )
 		{
+			bool measure = timer_stats_active;
+			TimerFunc func = timer_data[tid].func;
+			t_tick late = 0;
+			std::chrono::steady_clock::time_point start;
+
+			if( measure ) {
+				late = DIFF_TICK(gettick_nocache(), timer_data[tid].tick);
+				start = std::chrono::steady_clock::now();
+			}
+
 			if( diff < -1000 )
 				// timer was delayed for more than 1 second, use current tick instead
 				timer_data[tid].func(tid, tick, timer_data[tid].id, timer_data[tid].data);
 			else
 				timer_data[tid].func(tid, timer_data[tid].tick, timer_data[tid].id, timer_data[tid].data);
+
+			if( measure )
+				timer_stats_record(func, late, (uint64)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
 		}
 
 		// in the case the function didn't change anything...
@@ -402,9 +582,24 @@ t_tick do_timer(t_tick tick)
 		}
 	}
 
+	if( !timer_deferred.empty() )
+	{// carried over timers are due, come back as soon as possible
+		for( int tid : timer_deferred )
+			push_timer_heap(tid);
+		timer_deferred.clear();
+		diff = 0;
+	}
+
 	return cap_value(diff, TIMER_MIN_INTERVAL, TIMER_MAX_INTERVAL);
 }
 
+/// Sets the time in ms after which a do_timer loop stops executing expired background timers
+/// and carries them over to the next loop. 0 disables the budget.
+void timer_set_background_budget(t_tick budget)
+{
+	timer_background_budget = max(budget, (t_tick)0);
+}
+
 unsigned long get_uptime(void)
 {
 	return (unsigned long)difftime(time(NULL), start_time);
@@ -528,6 +723,9 @@ void timer_final(void)
 		aFree(tfl);
 	}
 
+	timer_stats_db.clear();
+	timer_deferred.clear();
+
 	if (timer_data) aFree(timer_data);
 	BHEAP_CLEAR(timer_heap);
 	if (free_timer_list) aFree(free_timer_list);
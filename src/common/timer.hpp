@@ -4,6 +4,8 @@
 #ifndef TIMER_HPP
 #define TIMER_HPP
 
+#include <vector>
+
 #include <time.h>
 
 #include "cbasetypes.hpp"
@@ -32,6 +34,12 @@ enum {
 
 #define TIMER_FUNC(x) int x ( int tid, t_tick tick, int id, intptr_t data )
 
+// timer priorities
+enum e_timer_priority : uint8 {
+	TIMER_PRIORITY_REALTIME = 0,	// always executed once expired
+	TIMER_PRIORITY_BACKGROUND,		// carried over to the next loop once the background budget of the current loop is exhausted
+};
+
 // Struct declaration
 typedef TIMER_FUNC((*TimerFunc));
 
@@ -40,19 +48,35 @@ struct TimerData {
 	TimerFunc func;
 	unsigned int type;
 	int interval;
+	enum e_timer_priority priority;
 
 	// general-purpose storage
 	int id;
 	intptr_t data;
 };
 
+// Number of execution time buckets in the timer statistics
+#define TIMER_STATS_BUCKETS 10
+
+/// Execution statistics of a timer function
+struct s_timer_stats {
+	const char* name;
+	uint64 calls;
+	uint64 time;		// total execution time in microseconds
+	uint64 time_max;	// longest execution in microseconds
+	uint64 late;		// total late-fire latency (execution tick - scheduled tick) in milliseconds
+	uint64 late_max;	// highest late-fire latency in milliseconds
+	uint64 deferred;	// times the execution was carried over to the next loop
+	uint64 histogram[TIMER_STATS_BUCKETS];	// execution time distribution, see timer_stats_bucket_limit
+};
+
 // Function prototype declaration
 
 t_tick gettick(void);
 t_tick gettick_nocache(void);
 
-int add_timer(t_tick tick, TimerFunc func, int id, intptr_t data);
-int add_timer_interval(t_tick tick, TimerFunc func, int id, intptr_t data, int interval);
+int add_timer(t_tick tick, TimerFunc func, int id, intptr_t data, enum e_timer_priority priority = TIMER_PRIORITY_REALTIME);
+int add_timer_interval(t_tick tick, TimerFunc func, int id, intptr_t data, int interval, enum e_timer_priority priority = TIMER_PRIORITY_REALTIME);
 const struct TimerData* get_timer(int tid);
 int delete_timer(int tid, TimerFunc func);
 
@@ -60,6 +84,15 @@ t_tick addt_tickimer(int tid, t_tick tick);
 t_tick sett_tickimer(int tid, t_tick tick);
 
 int add_timer_func_list(TimerFunc func, const char* name);
+void timer_stats_enable(bool enable);
+bool timer_stats_enabled(void);
+void timer_stats_reset(void);
+std::vector<struct s_timer_stats> timer_stats_get(void);
+uint64 timer_stats_bucket_limit(int bucket);
+void timer_stats_report(void);
+bool timer_stats_dump(const char* filename, bool reset);
+
+void timer_set_background_budget(t_tick budget);
 
 unsigned long get_uptime(void);
 
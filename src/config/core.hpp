@@ -68,6 +68,11 @@
 /// Comment to disable warnings for deprecated script constants
 #define SCRIPT_CONSTANT_DEPRECATION
 
+/// Uncomment to enable the @battlebench command.
+/// The damage calculation then checks for a dry run before every side effect on attacker and target,
+/// don't enable it on live servers.
+//#define BATTLE_BENCHMARK
+
 // Uncomment to enable deprecated support for Windows XP and lower
 // Note:
 // Windows XP still has 32bit ticks. This means you need to restart your operating system before time
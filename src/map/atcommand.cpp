@@ -3,8 +3,11 @@
 
 #include "atcommand.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <set>
 #include <unordered_map>
+#include <vector>
 
 #include <math.h>
 #include <stdlib.h>
@@ -10294,6 +10297,193 @@ ACMD_FUNC(upgradeui) {
 	return 0;
 }
 
+/**
+ * Displays the most expensive packet types recorded by the packet profiler.
+ * Usage: @packetstats {<recv|send> {<count|bytes|time>}} or @packetstats reset
+ */
+ACMD_FUNC(packetstats){
+	char direction[8] = "recv", order[8] = "time";
+	const int max_rows = 10;
+	enum e_packet_profile_dir dir;
+
+	nullpo_retr(-1, sd);
+
+	if( message != nullptr && message[0] != '\0' && sscanf( message, "%7s %7s", direction, order ) < 1 ){
+		clif_displaymessage( fd, msg_txt( sd, 1513 ) ); // Usage: @packetstats {<recv|send> {<count|bytes|time>}} or @packetstats reset
+		return -1;
+	}
+
+	if( !strcmpi( direction, "reset" ) ){
+		clif_packet_profile_reset();
+		clif_displaymessage( fd, msg_txt( sd, 1515 ) ); // Packet profiler data has been reset.
+		return 0;
+	}
+
+	if( !strcmpi( direction, "recv" ) )
+		dir = PACKET_PROFILE_RECV;
+	else if( !strcmpi( direction, "send" ) )
+		dir = PACKET_PROFILE_SEND;
+	else{
+		clif_displaymessage( fd, msg_txt( sd, 1513 ) ); // Usage: @packetstats {<recv|send> {<count|bytes|time>}} or @packetstats reset
+		return -1;
+	}
+
+	if( strcmpi( order, "count" ) && strcmpi( order, "bytes" ) && strcmpi( order, "time" ) ){
+		clif_displaymessage( fd, msg_txt( sd, 1513 ) ); // Usage: @packetstats {<recv|send> {<count|bytes|time>}} or @packetstats reset
+		return -1;
+	}
+
+	if( battle_config.packet_profile_rate <= 0 ){
+		clif_displaymessage( fd, msg_txt( sd, 1514 ) ); // The packet profiler is disabled (packet_profile_rate is 0).
+		return -1;
+	}
+
+	std::vector<uint16> packets;
+
+	for( uint16 cmd = 0; cmd <= MAX_PACKET_DB; cmd++ ){
+		if( clif_packet_profile_get( dir, cmd )->count > 0 )
+			packets.push_back( cmd );
+	}
+
+	if( packets.empty() ){
+		clif_displaymessage( fd, msg_txt( sd, 1516 ) ); // No packets have been recorded yet.
+		return 0;
+	}
+
+	bool by_count = !strcmpi( order, "count" ), by_bytes = !strcmpi( order, "bytes" );
+
+	std::sort( packets.begin(), packets.end(), [dir, by_count, by_bytes]( uint16 a, uint16 b ) -> bool {
+		const struct s_packet_profile* pa = clif_packet_profile_get( dir, a );
+		const struct s_packet_profile* pb = clif_packet_profile_get( dir, b );
+
+		if( by_count )
+			return pa->count > pb->count;
+		if( by_bytes )
+			return pa->bytes > pb->bytes;
+		return pa->time > pb->time;
+	} );
+
+	int rows = min( max_rows, (int)packets.size() );
+
+	sprintf( atcmd_output, msg_txt( sd, 1517 ), rows, direction, order ); // Top %d %s packets by %s:
+	clif_displaymessage( fd, atcmd_output );
+
+	for( int i = 0; i < rows; i++ ){
+		const struct s_packet_profile* profile = clif_packet_profile_get( dir, packets[i] );
+
+		// 0x%04X: %llu packets, %llu bytes, %llu us total, %llu us avg, %llu us max
+		sprintf( atcmd_output, msg_txt( sd, 1518 ), packets[i], (unsigned long long)profile->count, (unsigned long long)profile->bytes,
+			(unsigned long long)( profile->time / 1000 ), (unsigned long long)( profile->samples ? profile->time / profile->samples / 1000 : 0 ),
+			(unsigned long long)( profile->max / 1000 ) );
+		clif_displaymessage( fd, atcmd_output );
+	}
+
+	return 0;
+}
+
+/**
+ * Displays the timer functions with the highest total execution time.
+ * Usage: @timerstats {<on|off|reset>}
+ */
+ACMD_FUNC(timerstats){
+	char option[8] = "";
+	const int max_rows = 10;
+
+	nullpo_retr(-1, sd);
+
+	if( message != nullptr && message[0] != '\0' ){
+		if( sscanf( message, "%7s", option ) < 1 || ( strcmpi( option, "on" ) && strcmpi( option, "off" ) && strcmpi( option, "reset" ) ) ){
+			clif_displaymessage( fd, msg_txt( sd, 1519 ) ); // Usage: @timerstats {<on|off|reset>}
+			return -1;
+		}
+
+		if( !strcmpi( option, "reset" ) ){
+			timer_stats_reset();
+			clif_displaymessage( fd, msg_txt( sd, 1520 ) ); // Timer statistics have been reset.
+		}else{
+			battle_config.timer_stats = !strcmpi( option, "on" );
+			timer_stats_enable( battle_config.timer_stats != 0 );
+			clif_displaymessage( fd, msg_txt( sd, battle_config.timer_stats ? 1521 : 1522 ) ); // Timer statistics are enabled. / Timer statistics are disabled.
+		}
+
+		return 0;
+	}
+
+	std::vector<struct s_timer_stats> stats = timer_stats_get();
+
+	if( stats.empty() ){
+		clif_displaymessage( fd, msg_txt( sd, timer_stats_enabled() ? 1523 : 1522 ) ); // No timer executions have been recorded yet. / Timer statistics are disabled.
+		return 0;
+	}
+
+	int rows = min( max_rows, (int)stats.size() );
+
+	sprintf( atcmd_output, msg_txt( sd, 1524 ), rows ); // Top %d timer functions by execution time:
+	clif_displaymessage( fd, atcmd_output );
+
+	for( int i = 0; i < rows; i++ ){
+		const struct s_timer_stats& it = stats[i];
+
+		// %s: %llu calls, %llu us total, %llu us avg, %llu us max, %llu ms avg late, %llu ms max late, %llu deferred
+		sprintf( atcmd_output, msg_txt( sd, 1525 ), it.name, (unsigned long long)it.calls, (unsigned long long)it.time, (unsigned long long)( it.calls ? it.time / it.calls : 0 ),
+			(unsigned long long)it.time_max, (unsigned long long)( it.calls ? it.late / it.calls : 0 ), (unsigned long long)it.late_max, (unsigned long long)it.deferred );
+		clif_displaymessage( fd, atcmd_output );
+	}
+
+	return 0;
+}
+
+#ifdef BATTLE_BENCHMARK
+/**
+ * Measures the damage and status calculation of the player.
+ * The attack is calculated against the current attack target or the player itself.
+ * Usage: @battlebench <iterations> {<skill id> {<skill level>}}
+ */
+ACMD_FUNC(battlebench){
+	int iterations = 0, skill_id = 0, skill_lv = 1;
+
+	nullpo_retr(-1, sd);
+
+	if( !message || !*message || sscanf( message, "%11d %11d %11d", &iterations, &skill_id, &skill_lv ) < 1 || iterations < 1 || iterations > 100000 ){
+		clif_displaymessage( fd, msg_txt( sd, 1526 ) ); // Usage: @battlebench <iterations> {<skill id> {<skill level>}} (max 100000 iterations)
+		return -1;
+	}
+
+	if( skill_id && !skill_get_index( skill_id ) ){
+		clif_displaymessage( fd, msg_txt( sd, 198 ) ); // This skill number doesn't exist.
+		return -1;
+	}
+
+	if( skill_id )
+		skill_lv = cap_value( skill_lv, 1, skill_get_max( skill_id ) );
+	else
+		skill_lv = 0;
+
+	struct block_list* target = map_id2bl( sd->ud.target );
+
+	if( target == nullptr || target->m != sd->bl.m )
+		target = &sd->bl;
+
+	int64 checksum;
+	uint64 time = battle_calc_benchmark( &sd->bl, target, skill_id, skill_lv, iterations, &checksum );
+
+	sprintf( atcmd_output, msg_txt( sd, 1527 ), iterations, (unsigned long long)time, (unsigned long long)( time * 1000 / iterations ), (long long)checksum ); // Damage calculation: %d runs in %llu us (%llu ns avg), checksum %lld
+	clif_displaymessage( fd, atcmd_output );
+
+	auto start = std::chrono::steady_clock::now();
+
+	for( int i = 0; i < iterations; i++ )
+		status_calc_pc( sd, SCO_FORCE );
+
+	time = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start ).count();
+
+	sprintf( atcmd_output, msg_txt( sd, 1528 ), iterations, (unsigned long long)time, (unsigned long long)( time * 1000 / iterations ) ); // Status calculation: %d runs in %llu us (%llu ns avg)
+	clif_displaymessage( fd, atcmd_output );
+
+	return 0;
+}
+#endif
+
 // (^~_~^) Gepard Shield Start
 
 ACMD_FUNC(gepard_block_nick)
@@ -11022,6 +11212,11 @@ void atcommand_basecommands(void) {
 		ACMD_DEF2("checkquest", quest),
 		ACMD_DEFR(synthesisui, ATCMD_NOCONSOLE | ATCMD_NOAUTOTRADE),
 		ACMD_DEFR(upgradeui, ATCMD_NOCONSOLE | ATCMD_NOAUTOTRADE),
+		ACMD_DEF(packetstats),
+		ACMD_DEF(timerstats),
+#ifdef BATTLE_BENCHMARK
+		ACMD_DEF(battlebench),
+#endif
 	};
 	AtCommandInfo* atcommand;
 	int i;
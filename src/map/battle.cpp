@@ -3,6 +3,7 @@
 
 #include "battle.hpp"
 
+#include <chrono>
 #include <math.h>
 #include <stdlib.h>
 
@@ -38,6 +39,11 @@ int attr_fix_table[MAX_ELE_LEVEL][ELE_MAX][ELE_MAX];
 
 struct Battle_Config battle_config;
 static struct eri *delay_damage_ers; //For battle delay damage structures.
+#ifdef BATTLE_BENCHMARK
+static bool battle_dryrun = false; ///< Set by battle_calc_benchmark, the calculation must not change attacker or target
+#else
+#define battle_dryrun false // normal builds contain no dry run checks
+#endif
 
 /**
  * Returns the current/list skill used by the bl
@@ -1023,6 +1029,10 @@ bool battle_status_block_damage(struct block_list *src, struct block_list *targe
 	if (!src || !target || !sc || !d)
 		return true;
 
+	// Blocking statuses are consumed or react to the hit, a measurement ignores them
+	if (battle_dryrun)
+		return true;
+
 	status_change_entry *sce;
 	int flag = d->flag;
 
@@ -1381,7 +1391,8 @@ int64 battle_calc_damage(struct block_list *src,struct block_list *bl,struct Dam
 #ifndef RENEWAL
 			if( skill_id != ASC_BREAKER || !(flag&BF_WEAPON) )
 #endif
-				status_change_end(bl, SC_AETERNA, INVALID_TIMER); //Shouldn't end until Breaker's non-weapon part connects.
+				if( !battle_dryrun )
+					status_change_end(bl, SC_AETERNA, INVALID_TIMER); //Shouldn't end until Breaker's non-weapon part connects.
 		}
 
 #ifdef RENEWAL
@@ -1397,7 +1408,8 @@ int64 battle_calc_damage(struct block_list *src,struct block_list *bl,struct Dam
 			struct map_session_data *tsd = BL_CAST(BL_PC, src);
 			if( sc->data[SC_DEEPSLEEP] ) {
 				damage += damage / 2; // 1.5 times more damage while in Deep Sleep.
-				status_change_end(bl,SC_DEEPSLEEP,INVALID_TIMER);
+				if( !battle_dryrun )
+					status_change_end(bl,SC_DEEPSLEEP,INVALID_TIMER);
 			}
 			if( tsd && sd && sc->data[SC_CRYSTALIZE] && flag&BF_WEAPON ) {
 				switch(tsd->status.weapon) {
@@ -1424,7 +1436,7 @@ int64 battle_calc_damage(struct block_list *src,struct block_list *bl,struct Dam
 						break;
 				}
 			}
-			if( sc->data[SC_VOICEOFSIREN] )
+			if( sc->data[SC_VOICEOFSIREN] && !battle_dryrun )
 				status_change_end(bl,SC_VOICEOFSIREN,INVALID_TIMER);
 		}
 
@@ -1515,7 +1527,7 @@ int64 battle_calc_damage(struct block_list *src,struct block_list *bl,struct Dam
 			int per = 100*status->sp / status->max_sp -1; //100% should be counted as the 80~99% interval
 			per /=20; //Uses 20% SP intervals.
 			//SP Cost: 1% + 0.5% per every 20% SP
-			if (!status_charge(bl, 0, (10+5*per)*status->max_sp/1000))
+			if (!battle_dryrun && !status_charge(bl, 0, (10+5*per)*status->max_sp/1000))
 				status_change_end(bl, SC_ENERGYCOAT, INVALID_TIMER);
 			damage -= damage * 6 * (1 + per) / 100; //Reduction: 6% + 6% every 20%
 		}
@@ -1528,10 +1540,10 @@ int64 battle_calc_damage(struct block_list *src,struct block_list *bl,struct Dam
 			damage = i64max(damage, 1);
 		}
 
-		if( (sce=sc->data[SC_MAGMA_FLOW]) && (rnd()%100 <= sce->val2) )
+		if( (sce=sc->data[SC_MAGMA_FLOW]) && (rnd()%100 <= sce->val2) && !battle_dryrun )
 			skill_castend_damage_id(bl,src,MH_MAGMA_FLOW,sce->val1,gettick(),0);
 
-		if( damage > 0 && (sce = sc->data[SC_STONEHARDSKIN]) ) {
+		if( damage > 0 && (sce = sc->data[SC_STONEHARDSKIN]) && !battle_dryrun ) {
 			if( src->type == BL_MOB ) //using explicit call instead break_equip for duration
 				sc_start(src,src, SC_STRIPWEAPON, 30, 0, skill_get_time2(RK_STONEHARDSKIN, sce->val1));
 			else if (flag&(BF_WEAPON|BF_SHORT))
@@ -1552,7 +1564,7 @@ int64 battle_calc_damage(struct block_list *src,struct block_list *bl,struct Dam
 #endif
 
 		//Finally added to remove the status of immobile when Aimed Bolt is used. [Jobbie]
-		if( skill_id == RA_AIMEDBOLT && (sc->data[SC_BITE] || sc->data[SC_ANKLE] || sc->data[SC_ELECTRICSHOCKER]) ) {
+		if( skill_id == RA_AIMEDBOLT && (sc->data[SC_BITE] || sc->data[SC_ANKLE] || sc->data[SC_ELECTRICSHOCKER]) && !battle_dryrun ) {
 			status_change_end(bl, SC_BITE, INVALID_TIMER);
 			status_change_end(bl, SC_ANKLE, INVALID_TIMER);
 			status_change_end(bl, SC_ELECTRICSHOCKER, INVALID_TIMER);
@@ -1561,10 +1573,10 @@ int64 battle_calc_damage(struct block_list *src,struct block_list *bl,struct Dam
 		if (!damage)
 			return 0;
 
-		if( sd && (sce = sc->data[SC_FORCEOFVANGUARD]) && flag&BF_WEAPON && rnd()%100 < sce->val2 )
+		if( sd && (sce = sc->data[SC_FORCEOFVANGUARD]) && flag&BF_WEAPON && rnd()%100 < sce->val2 && !battle_dryrun )
 			pc_addspiritball(sd,skill_get_time(LG_FORCEOFVANGUARD,sce->val1),sce->val3);
 
-		if( sd && (sce = sc->data[SC_GT_ENERGYGAIN]) && flag&BF_WEAPON && rnd()%100 < sce->val2 ) {
+		if( sd && (sce = sc->data[SC_GT_ENERGYGAIN]) && flag&BF_WEAPON && rnd()%100 < sce->val2 && !battle_dryrun ) {
 			int spheres = 5;
 
 			if( sc->data[SC_RAISINGDRAGON] )
@@ -1576,11 +1588,11 @@ int64 battle_calc_damage(struct block_list *src,struct block_list *bl,struct Dam
 		if (sc->data[SC_STYLE_CHANGE] && sc->data[SC_STYLE_CHANGE]->val1 == MH_MD_GRAPPLING) {
 			TBL_HOM *hd = BL_CAST(BL_HOM,bl); // We add a sphere for when the Homunculus is being hit
 
-			if (hd && (rnd()%100<50) ) // According to WarpPortal, this is a flat 50% chance
+			if (hd && (rnd()%100<50) && !battle_dryrun ) // According to WarpPortal, this is a flat 50% chance
 				hom_addspiritball(hd, 10);
 		}
 
-		if( sc->data[SC__DEADLYINFECT] && (flag&(BF_SHORT|BF_MAGIC)) == BF_SHORT && damage > 0 && rnd()%100 < 30 + 10 * sc->data[SC__DEADLYINFECT]->val1 )
+		if( sc->data[SC__DEADLYINFECT] && (flag&(BF_SHORT|BF_MAGIC)) == BF_SHORT && damage > 0 && rnd()%100 < 30 + 10 * sc->data[SC__DEADLYINFECT]->val1 && !battle_dryrun )
 			status_change_spread(bl, src, 1); // Deadly infect attacked side
 
 	} //End of target SC_ check
@@ -1592,7 +1604,7 @@ int64 battle_calc_damage(struct block_list *src,struct block_list *bl,struct Dam
 		if( sc->data[SC_INVINCIBLE] && !sc->data[SC_INVINCIBLEOFF] )
 			damage += damage * 75 / 100;
 
-		if ((sce = sc->data[SC_BLOODLUST]) && flag&BF_WEAPON && damage > 0 && rnd()%100 < sce->val3)
+		if ((sce = sc->data[SC_BLOODLUST]) && flag&BF_WEAPON && damage > 0 && rnd()%100 < sce->val3 && !battle_dryrun)
 			status_heal(src, damage * sce->val4 / 100, 0, 3);
 
 		if (flag&BF_MAGIC && bl->type == BL_PC && sc->data[SC_GVG_GIANT] && sc->data[SC_GVG_GIANT]->val4)
@@ -1619,24 +1631,24 @@ int64 battle_calc_damage(struct block_list *src,struct block_list *bl,struct Dam
 			}
 		}
 		/* Self Buff that destroys the armor of any target hit with melee or ranged physical attacks */
-		if( sc->data[SC_SHIELDSPELL_REF] && sc->data[SC_SHIELDSPELL_REF]->val1 == 1 && flag&BF_WEAPON ) {
+		if( sc->data[SC_SHIELDSPELL_REF] && sc->data[SC_SHIELDSPELL_REF]->val1 == 1 && flag&BF_WEAPON && !battle_dryrun ) {
 			skill_break_equip(src,bl, EQP_ARMOR, 10000, BCT_ENEMY); // 100% chance (http://irowiki.org/wiki/Shield_Spell#Level_3_spells_.28refine_based.29)
 			status_change_end(src,SC_SHIELDSPELL_REF,INVALID_TIMER);
 		}
 
 		if (sc->data[SC_POISONINGWEAPON] && flag&BF_SHORT && (skill_id == 0 || skill_id == GC_VENOMPRESSURE) && damage > 0) {
 			damage += damage * 10 / 100;
-			if (rnd() % 100 < sc->data[SC_POISONINGWEAPON]->val3)
+			if (rnd() % 100 < sc->data[SC_POISONINGWEAPON]->val3 && !battle_dryrun)
 				sc_start4(src, bl, (sc_type)sc->data[SC_POISONINGWEAPON]->val2, 100, sc->data[SC_POISONINGWEAPON]->val1, 0, 1, 0, skill_get_time2(GC_POISONINGWEAPON, 1));
 		}
 
-		if( sc->data[SC__DEADLYINFECT] && (flag&(BF_SHORT|BF_MAGIC)) == BF_SHORT && damage > 0 && rnd()%100 < 30 + 10 * sc->data[SC__DEADLYINFECT]->val1 )
+		if( sc->data[SC__DEADLYINFECT] && (flag&(BF_SHORT|BF_MAGIC)) == BF_SHORT && damage > 0 && rnd()%100 < 30 + 10 * sc->data[SC__DEADLYINFECT]->val1 && !battle_dryrun )
 			status_change_spread(src, bl, 0);
 
 		if (sc->data[SC_STYLE_CHANGE] && sc->data[SC_STYLE_CHANGE]->val1 == MH_MD_FIGHTING) {
 			TBL_HOM *hd = BL_CAST(BL_HOM,src); //when attacking
 
-			if (hd && (rnd()%100<50) ) hom_addspiritball(hd, 10); // According to WarpPortal, this is a flat 50% chance
+			if (hd && (rnd()%100<50) && !battle_dryrun ) hom_addspiritball(hd, 10); // According to WarpPortal, this is a flat 50% chance
 		}
 
 		if (flag & BF_WEAPON && (sce = sc->data[SC_ADD_ATK_DAMAGE]))
@@ -1651,7 +1663,7 @@ int64 battle_calc_damage(struct block_list *src,struct block_list *bl,struct Dam
 		map_session_data *tsd = (map_session_data *)src;
 
 		if (tsd && (sce = sc->data[SC_SOULREAPER])) {
-			if (rnd()%100 < sce->val2 && tsd->soulball < MAX_SOUL_BALL) {
+			if (rnd()%100 < sce->val2 && tsd->soulball < MAX_SOUL_BALL && !battle_dryrun) {
 				clif_specialeffect(src, 1208, AREA);
 				pc_addsoulball(tsd, 0, 5 + 3 * pc_checkskill(tsd, SP_SOULENERGY));
 			}
@@ -2558,8 +2570,10 @@ static bool is_attack_critical(struct Damage* wd, struct block_list *src, struct
 			case 0:
 				if(sc && !sc->data[SC_AUTOCOUNTER])
 					break;
-				clif_specialeffect(src, EF_AUTOCOUNTER, AREA);
-				status_change_end(src, SC_AUTOCOUNTER, INVALID_TIMER);
+				if (!battle_dryrun) {
+					clif_specialeffect(src, EF_AUTOCOUNTER, AREA);
+					status_change_end(src, SC_AUTOCOUNTER, INVALID_TIMER);
+				}
 			case KN_AUTOCOUNTER:
 				if(battle_config.auto_counter_type &&
 					(battle_config.auto_counter_type&src->type))
@@ -3548,7 +3562,7 @@ static void battle_calc_multi_attack(struct Damage* wd, struct block_list *src,s
 
 			status_data *status = status_get_status_data(src);
 
-			if (status && status->amotion > 70) // Only triggers if ASPD < 193
+			if (status && status->amotion > 70 && !battle_dryrun) // Only triggers if ASPD < 193
 				sc_start(src,src,SC_QD_SHOT_READY,100,target->id,skill_get_time(RL_QD_SHOT,1));
 		}
 		else if(sc && sc->data[SC_FEARBREEZE] && sd->weapontype1==W_BOW
@@ -3563,7 +3577,8 @@ static void battle_calc_multi_attack(struct Damage* wd, struct block_list *src,s
 				case 1: if( chance < 13) { wd->div_ = 2; break; } // 12 % chance to attack 2 times.
 			}
 			wd->div_ = min(wd->div_,sd->inventory.u.items_inventory[i].amount);
-			sc->data[SC_FEARBREEZE]->val4 = wd->div_-1;
+			if (!battle_dryrun)
+				sc->data[SC_FEARBREEZE]->val4 = wd->div_-1;
 			if (wd->div_ > 1)
 				wd->type = DMG_MULTI_HIT;
 		}
@@ -3635,8 +3650,10 @@ static int battle_calc_attack_skill_ratio(struct Damage* wd, struct block_list *
 						skillratio += -100 + sd->inventory_data[index]->weight / 10 + sd->inventory_data[index]->atk +
 							100 * sd->inventory_data[index]->wlv * (sd->inventory.u.items_inventory[index].refine + 6);
 				}
-				status_change_end(src,SC_CRUSHSTRIKE,INVALID_TIMER);
-				skill_break_equip(src,src,EQP_WEAPON,2000,BCT_SELF);
+				if (!battle_dryrun) {
+					status_change_end(src,SC_CRUSHSTRIKE,INVALID_TIMER);
+					skill_break_equip(src,src,EQP_WEAPON,2000,BCT_SELF);
+				}
 			} else {
 				if (sc->data[SC_GIANTGROWTH] && (sd->class_&MAPID_THIRDMASK) == MAPID_RUNE_KNIGHT) { // Increase damage again if Crush Strike is not active
 					if (map_flag_vs(src->m)) // Only half of the 2.5x increase on versus-type maps
@@ -5221,7 +5238,7 @@ static void battle_calc_attack_plant(struct Damage* wd, struct block_list *src,s
 	struct status_data *tstatus = status_get_status_data(target);
 	bool attack_hits = is_attack_hitting(wd, src, target, skill_id, skill_lv, false);
 
-	if (skill_id != SN_SHARPSHOOTING && skill_id != RA_ARROWSTORM)
+	if (skill_id != SN_SHARPSHOOTING && skill_id != RA_ARROWSTORM && !battle_dryrun)
 		status_change_end(src, SC_CAMOUFLAGE, INVALID_TIMER);
 
 	//Plants receive 1 damage when hit
@@ -5357,7 +5374,7 @@ struct block_list *battle_check_devotion(struct block_list *bl) {
 static void battle_calc_attack_gvg_bg(struct Damage* wd, struct block_list *src,struct block_list *target,uint16 skill_id,uint16 skill_lv)
 {
 	if( wd->damage + wd->damage2 ) { //There is a total damage value
-		if( src != target && //Don't reflect your own damage (Grand Cross)
+		if( src != target && !battle_dryrun && //Don't reflect your own damage (Grand Cross)
 			(!skill_id || skill_id ||
 			(src->type == BL_SKILL && (skill_id == SG_SUN_WARM || skill_id == SG_MOON_WARM || skill_id == SG_STAR_WARM))) ) {
 				int64 damage = wd->damage + wd->damage2, rdamage = 0;
@@ -5427,7 +5444,7 @@ static void battle_calc_weapon_final_atk_modifiers(struct Damage* wd, struct blo
 	int skill_damage = 0;
 
 	//Reject Sword bugreport:4493 by Daegaladh
-	if(wd->damage && tsc && tsc->data[SC_REJECTSWORD] &&
+	if(wd->damage && tsc && tsc->data[SC_REJECTSWORD] && !battle_dryrun &&
 		(src->type!=BL_PC || (
 			((TBL_PC *)src)->weapontype1 == W_DAGGER ||
 			((TBL_PC *)src)->weapontype1 == W_1HSWORD ||
@@ -5443,7 +5460,7 @@ static void battle_calc_weapon_final_atk_modifiers(struct Damage* wd, struct blo
 			status_change_end(target, SC_REJECTSWORD, INVALID_TIMER);
 	}
 
-	if( tsc && tsc->data[SC_CRESCENTELBOW] && wd->flag&BF_SHORT && rnd()%100 < tsc->data[SC_CRESCENTELBOW]->val2 ) {
+	if( tsc && tsc->data[SC_CRESCENTELBOW] && wd->flag&BF_SHORT && rnd()%100 < tsc->data[SC_CRESCENTELBOW]->val2 && !battle_dryrun ) {
 		//ATK [{(Target HP / 100) x Skill Level} x Caster Base Level / 125] % + [Received damage x {1 + (Skill Level x 0.2)}]
 		int64 rdamage = 0;
 		int ratio = (int64)(status_get_hp(src) / 100) * tsc->data[SC_CRESCENTELBOW]->val1 * status_get_lv(target) / 125;
@@ -5461,7 +5478,7 @@ static void battle_calc_weapon_final_atk_modifiers(struct Damage* wd, struct blo
 
 	if( sc ) {
 		//SC_FUSION hp penalty [Komurka]
-		if (sc->data[SC_FUSION]) {
+		if (sc->data[SC_FUSION] && !battle_dryrun) {
 			unsigned int hp = sstatus->max_hp;
 
 			if (sd && tsd) {
@@ -5486,7 +5503,7 @@ static void battle_calc_weapon_final_atk_modifiers(struct Damage* wd, struct blo
 					ATK_ADD(wd->damage, wd->damage2, enchant_dmg);
 			}
 		}
-		if (skill_id != SN_SHARPSHOOTING && skill_id != RA_ARROWSTORM)
+		if (skill_id != SN_SHARPSHOOTING && skill_id != RA_ARROWSTORM && !battle_dryrun)
 			status_change_end(src, SC_CAMOUFLAGE, INVALID_TIMER);
 	}
 
@@ -5632,7 +5649,7 @@ static struct Damage initialize_weapon_data(struct block_list *src, struct block
 void battle_do_reflect(int attack_type, struct Damage *wd, struct block_list* src, struct block_list* target, uint16 skill_id, uint16 skill_lv)
 {
 	// Don't reflect your own damage (Grand Cross)
-	if ((wd->damage + wd->damage2) && src && target && src != target && (src->type != BL_SKILL ||
+	if (!battle_dryrun && (wd->damage + wd->damage2) && src && target && src != target && (src->type != BL_SKILL ||
 		(src->type == BL_SKILL && (skill_id == SG_SUN_WARM || skill_id == SG_MOON_WARM || skill_id == SG_STAR_WARM ))))
 	{
 		int64 damage = wd->damage + wd->damage2, rdamage = 0;
@@ -6583,7 +6600,8 @@ struct Damage battle_calc_magic_attack(struct block_list *src,struct block_list
 						if(sd && sd->spiritcharm_type != CHARM_TYPE_NONE && sd->spiritcharm > 0) {
 							skillratio += -100 + 200 * sd->spiritcharm;
 							RE_LVL_DMOD(100);
-							pc_delspiritcharm(sd, sd->spiritcharm, sd->spiritcharm_type);
+							if (!battle_dryrun)
+								pc_delspiritcharm(sd, sd->spiritcharm, sd->spiritcharm_type);
 						}
 						break;
 					// Magical Elemental Spirits Attack Skills
@@ -7250,6 +7268,53 @@ struct Damage battle_calc_attack(int attack_type,struct block_list *bl,struct bl
 	return d;
 }
 
+#ifdef BATTLE_BENCHMARK
+/**
+ * Measures the damage calculation of an attack with a fixed random seed.
+ * The calculation runs as a dry run: status changes are neither consumed nor started, nothing is
+ * damaged, healed, reflected or knocked back and no packets are sent. Statuses that block the hit
+ * (Kyrie Eleison, Safety Wall, Auto Guard, ...) are ignored for the same reason.
+ * @param src: Attacker
+ * @param target: Target
+ * @param skill_id: Skill to calculate, 0 for a normal attack
+ * @param skill_lv: Skill level
+ * @param iterations: Number of calculations
+ * @param checksum: Sum of the calculated damage, identical for runs with the same input
+ * @return Time spent in microseconds
+ */
+uint64 battle_calc_benchmark(struct block_list *src, struct block_list *target, uint16 skill_id, uint16 skill_lv, int iterations, int64 *checksum)
+{
+	int attack_type = skill_id ? skill_get_type(skill_id) : BF_WEAPON;
+
+	nullpo_ret(src);
+	nullpo_ret(target);
+
+	*checksum = 0;
+	rnd_seed(0x5EED);
+	battle_dryrun = true;
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (int i = 0; i < iterations; i++) {
+		struct Damage d;
+
+		switch (attack_type) {
+			case BF_MAGIC: d = battle_calc_magic_attack(src, target, skill_id, skill_lv, 1); break;
+			case BF_MISC:  d = battle_calc_misc_attack(src, target, skill_id, skill_lv, 1); break;
+			default:       d = battle_calc_weapon_attack(src, target, skill_id, skill_lv, 0); break;
+		}
+		*checksum += d.damage + d.damage2;
+	}
+
+	uint64 time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+	battle_dryrun = false;
+	rnd_init(); // Don't leave the server with a predictable generator
+
+	return time;
+}
+#endif
+
 /*==========================================
  * Final damage return function
  *------------------------------------------
@@ -8861,6 +8926,7 @@ static const struct _battle_data {
 	{ "feature.autotrade_head_direction",	&battle_config.feature_autotrade_head_direction,0,		-1,		2,				},
 	{ "feature.autotrade_sit",				&battle_config.feature_autotrade_sit,			1,		-1,		1,				},
 	{ "feature.autotrade_open_delay",		&battle_config.feature_autotrade_open_delay,	5000,	1000,	INT_MAX,		},
+	{ "feature.autotrade_restore_rate",		&battle_config.feature_autotrade_restore_rate,	500,	0,		INT_MAX,		},
 	{ "disp_servervip_msg",					&battle_config.disp_servervip_msg,				0,		0,		1,				},
 	{ "warg_can_falcon",                    &battle_config.warg_can_falcon,                 0,      0,      1,              },
 	{ "path_blown_halt",                    &battle_config.path_blown_halt,                 1,      0,      1,              },
@@ -8967,6 +9033,12 @@ static const struct _battle_data {
 	{ "rental_item_novalue",                &battle_config.rental_item_novalue,             1,      0,      1,              },
 	{ "homunculus_starving_rate",           &battle_config.homunculus_starving_rate,        10,     0,      100,            },
 	{ "homunculus_starving_delay",          &battle_config.homunculus_starving_delay,       20000,  0,      INT_MAX,        },
+	{ "packet_profile_rate",                &battle_config.packet_profile_rate,             0,      0,      INT_MAX,        },
+	{ "packet_profile_dump_interval",       &battle_config.packet_profile_dump_interval,    0,      0,      INT_MAX,        },
+	{ "timer_stats",                        &battle_config.timer_stats,                     0,      0,      1,              },
+	{ "timer_stats_dump_interval",          &battle_config.timer_stats_dump_interval,       0,      0,      INT_MAX,        },
+	{ "timer_background_budget",            &battle_config.timer_background_budget,         0,      0,      1000,           },
+	{ "mob_lazy_sweep_interval",            &battle_config.mob_lazy_sweep_interval,         10,     1,      100,            },
 	/**
 	* Extended Vending system [Lilith]
 	**/
@@ -9153,6 +9225,9 @@ void battle_adjust_conf()
 	}
 #endif
 
+	timer_stats_enable(battle_config.timer_stats != 0);
+	timer_set_background_budget(battle_config.timer_background_budget);
+
 #ifndef CELL_NOSTACK
 	if (battle_config.custom_cell_stack_limit != 1)
 		ShowWarning("Battle setting 'custom_cell_stack_limit' takes no effect as this server was compiled without Cell Stack Limit support.\n");
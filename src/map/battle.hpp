@@ -93,6 +93,9 @@ extern int attr_fix_table[MAX_ELE_LEVEL][ELE_MAX][ELE_MAX];
 // Damage Calculation
 
 struct Damage battle_calc_attack(int attack_type,struct block_list *bl,struct block_list *target,uint16 skill_id,uint16 skill_lv,int flag);
+#ifdef BATTLE_BENCHMARK
+uint64 battle_calc_benchmark(struct block_list *src, struct block_list *target, uint16 skill_id, uint16 skill_lv, int iterations, int64 *checksum);
+#endif
 
 int64 battle_calc_return_damage(struct block_list *bl, struct block_list *src, int64 *, int flag, uint16 skill_id, bool status_reflect);
 
@@ -572,6 +575,7 @@ struct Battle_Config
 	int feature_autotrade_head_direction;
 	int feature_autotrade_sit;
 	int feature_autotrade_open_delay;
+	int feature_autotrade_restore_rate;
 
 	// Fame points
 	int fame_taekwon_mission;
@@ -680,6 +684,12 @@ struct Battle_Config
 	int rental_item_novalue;
 	int homunculus_starving_rate;
 	int homunculus_starving_delay;
+	int packet_profile_rate;
+	int packet_profile_dump_interval;
+	int timer_stats;
+	int timer_stats_dump_interval;
+	int timer_background_budget;
+	int mob_lazy_sweep_interval;
 	/**
 	* Extended Vending system [Lilith]
 	**/
@@ -4,6 +4,8 @@
 #include "buyingstore.hpp"  // struct s_buyingstore
 
 #include <stdlib.h> // atoi
+#include <unordered_map>
+#include <vector>
 
 #include "../common/db.hpp"  // ARR_FIND
 #include "../common/malloc.hpp" // aMalloc, aFree
@@ -250,6 +252,7 @@ int8 buyingstore_create(struct map_session_data* sd, int zenylimit, unsigned cha
 	clif_buyingstore_myitemlist(sd);
 	clif_buyingstore_entry(sd);
 	idb_put(buyingstore_db, sd->status.char_id, sd);
+	searchstore_update(sd, SEARCHTYPE_BUYING_STORE);
 
 	return 0;
 }
@@ -273,6 +276,7 @@ void buyingstore_close(struct map_session_data* sd) {
 		sd->buyer_id = 0;
 		memset(&sd->buyingstore, 0, sizeof(sd->buyingstore));
 		idb_remove(buyingstore_db, sd->status.char_id);
+		searchstore_update(sd, SEARCHTYPE_BUYING_STORE);
 
 		// notify other players
 		clif_buyingstore_disappear_entry(sd);
@@ -475,6 +479,8 @@ void buyingstore_trade(struct map_session_data* sd, uint32 account_id, unsigned
 		clif_buyingstore_update_item(pl_sd, nameid, amount, sd->status.char_id, zeny);
 	}
 
+	searchstore_update(pl_sd, SEARCHTYPE_BUYING_STORE);
+
 	if( save_settings&CHARSAVE_VENDING ) {
 		chrif_save(sd, CSAVE_NORMAL|CSAVE_INVENTORY);
 		chrif_save(pl_sd, CSAVE_NORMAL|CSAVE_INVENTORY);
@@ -658,18 +664,19 @@ void do_init_buyingstore_autotrade( void ) {
 		if (Sql_Query(mmysql_handle,
 			"SELECT `id`, `account_id`, `char_id`, `sex`, `title`, `limit`, `body_direction`, `head_direction`, `sit` "
 			"FROM `%s` "
-			"WHERE `autotrade` = 1 AND `limit` > 0 AND (SELECT COUNT(`buyingstore_id`) FROM `%s` WHERE `buyingstore_id` = `id`) > 0 "
+			"WHERE `autotrade` = 1 AND `limit` > 0 "
 			"ORDER BY `id`;",
-			buyingstores_table, buyingstore_items_table ) != SQL_SUCCESS )
+			buyingstores_table ) != SQL_SUCCESS )
 		{
 			Sql_ShowDebug(mmysql_handle);
 			return;
 		}
 
 		if( Sql_NumRows(mmysql_handle) > 0 ) {
-			uint16 items = 0;
-			DBIterator *iter = NULL;
+			uint32 items = 0;
 			struct s_autotrader *at = NULL;
+			std::unordered_map<uint32, struct s_autotrader *> stores; // buyingstore_id -> autotrader
+			std::unordered_map<uint32, std::vector<struct s_autotrade_entry *>> store_items; // buyingstore_id -> items
 
 			// Init each autotrader data
 			while (SQL_SUCCESS == Sql_NextRow(mmysql_handle)) {
@@ -704,50 +711,57 @@ void do_init_buyingstore_autotrade( void ) {
 					at->sd->state.block_action |= PCBLOCK_IMMUNE;
 				else
 					at->sd->state.block_action &= ~PCBLOCK_IMMUNE;
-				chrif_authreq(at->sd, true);
 				uidb_put(buyingstore_autotrader_db, at->char_id, at);
+				stores[at->id] = at;
 			}
 			Sql_FreeResult(mmysql_handle);
-			
-			// Init items for each autotraders
-			iter = db_iterator(buyingstore_autotrader_db);
-			for (at = (struct s_autotrader *)dbi_first(iter); dbi_exists(iter); at = (struct s_autotrader *)dbi_next(iter)) {
-				uint16 j = 0;
-
-				if (SQL_ERROR == Sql_Query(mmysql_handle,
-					"SELECT `item_id`, `amount`, `price` "
-					"FROM `%s` "
-					"WHERE `buyingstore_id` = %d "
-					"ORDER BY `index` ASC;",
-					buyingstore_items_table, at->id ) )
-				{
-					Sql_ShowDebug(mmysql_handle);
-					continue;
+
+			// Init items for all autotraders at once
+			if (SQL_ERROR == Sql_Query(mmysql_handle,
+				"SELECT `i`.`buyingstore_id`, `i`.`item_id`, `i`.`amount`, `i`.`price` "
+				"FROM `%s` `i` JOIN `%s` `b` ON `b`.`id` = `i`.`buyingstore_id` "
+				"WHERE `b`.`autotrade` = 1 AND `b`.`limit` > 0 "
+				"ORDER BY `i`.`buyingstore_id`, `i`.`index` ASC;",
+				buyingstore_items_table, buyingstores_table ) )
+			{
+				Sql_ShowDebug(mmysql_handle);
+			} else {
+				while (SQL_SUCCESS == Sql_NextRow(mmysql_handle)) {
+					struct s_autotrade_entry *entry;
+					char *data;
+					uint32 id;
+
+					Sql_GetData(mmysql_handle, 0, &data, NULL); id = atoi(data);
+
+					if (stores.find(id) == stores.end())
+						continue;
+
+					CREATE(entry, struct s_autotrade_entry, 1);
+					Sql_GetData(mmysql_handle, 1, &data, NULL); entry->item_id = atoi(data);
+					Sql_GetData(mmysql_handle, 2, &data, NULL); entry->amount = atoi(data);
+					Sql_GetData(mmysql_handle, 3, &data, NULL); entry->price = atoi(data);
+					store_items[id].push_back(entry);
 				}
+				Sql_FreeResult(mmysql_handle);
+			}
 
-				if (!(at->count = (uint16)Sql_NumRows(mmysql_handle))) {
-					map_quit(at->sd);
+			// Hand the list to each autotrader and queue its login
+			for (const auto &it : stores) {
+				std::vector<struct s_autotrade_entry *> &list = store_items[it.first];
+
+				at = it.second;
+
+				if (!(at->count = (uint16)list.size())) {
+					aFree(at->sd); // not logged in yet
 					buyingstore_autotrader_remove(at, true);
 					continue;
 				}
-			
-				//Init the list
-				CREATE(at->entries, struct s_autotrade_entry *,at->count);
 
-				//Add the item into list
-				j = 0;
-				while (SQL_SUCCESS == Sql_NextRow(mmysql_handle) && j < at->count) {
-					char *data;
-					CREATE(at->entries[j], struct s_autotrade_entry, 1);
-					Sql_GetData(mmysql_handle, 0, &data, NULL); at->entries[j]->item_id = atoi(data);
-					Sql_GetData(mmysql_handle, 1, &data, NULL); at->entries[j]->amount = atoi(data);
-					Sql_GetData(mmysql_handle, 2, &data, NULL); at->entries[j]->price = atoi(data);
-					j++;
-				}
-				items += j;
-				Sql_FreeResult(mmysql_handle);
+				CREATE(at->entries, struct s_autotrade_entry *, at->count);
+				memcpy(at->entries, list.data(), at->count * sizeof(struct s_autotrade_entry *));
+				items += at->count;
+				pc_autotrade_restore(at->sd);
 			}
-			dbi_destroy(iter);
 
 			ShowStatus("Done loading '" CL_WHITE "%d" CL_RESET "' buyingstore autotraders with '" CL_WHITE "%d" CL_RESET "' items.\n", db_size(buyingstore_autotrader_db), items);
 		}
@@ -761,6 +775,24 @@ void do_init_buyingstore_autotrade( void ) {
 	}
 }
 
+/**
+ * Discard a restored autotrader that is not logged in yet, e.g. because its account is online already
+ * The player data is not freed.
+ * @param sd Player as autotrader
+ */
+void buyingstore_autotrader_discard( struct map_session_data* sd ){
+	struct s_autotrader *at;
+
+	nullpo_retv(sd);
+
+	if (!(at = (struct s_autotrader *)uidb_get(buyingstore_autotrader_db, sd->status.char_id)) || at->sd != sd)
+		return;
+
+	buyingstore_autotrader_remove(at, true);
+	if (db_size(buyingstore_autotrader_db) == 0)
+		buyingstore_autotrader_db->clear(buyingstore_autotrader_db, buyingstore_autotrader_free);
+}
+
 /**
  * Remove an autotrader's data
  * @param at Autotrader
@@ -69,5 +69,6 @@ void do_init_buyingstore(void);
 
 void do_init_buyingstore_autotrade( void );
 void buyingstore_reopen( struct map_session_data* sd );
+void buyingstore_autotrader_discard( struct map_session_data* sd );
 
 #endif /* BUYINGSTORE_HPP */
@@ -46,7 +46,7 @@ static const int packet_len_table[0x3d] = { // U - used, F - free
 	11,10,10, 0,11, -1, 0,10,	// 2b10-2b17: U->2b10, U->2b11, U->2b12, F->2b13, U->2b14, U->2b15, F->2b16, U->2b17
 	 2,10, 2,-1,-1,-1, 2, 7,	// 2b18-2b1f: U->2b18, U->2b19, U->2b1a, U->2b1b, U->2b1c, U->2b1d, U->2b1e, U->2b1f
 	-1,10, 8, 2, 2,14,19,19,	// 2b20-2b27: U->2b20, U->2b21, U->2b22, U->2b23, U->2b24, U->2b25, U->2b26, U->2b27
-	-1, 0, 6,15, 0, 6,-1,-1,	// 2b28-2b2f: U->2b28, F->2b29, U->2b2a, U->2b2b, F->2b2c, U->2b2d, U->2b2e, U->2b2f
+	-1,10, 6,15, 0, 6,-1,-1,	// 2b28-2b2f: U->2b28, U->2b29, U->2b2a, U->2b2b, F->2b2c, U->2b2d, U->2b2e, U->2b2f
  };
 
 //Used Packets:
@@ -98,10 +98,10 @@ static const int packet_len_table[0x3d] = { // U - used, F - free
 //2b26: Outgoing, chrif_authreq -> 'client authentication request'
 //2b27: Incoming, chrif_authfail -> 'client authentication failed'
 //2b28: Outgoing, chrif_req_charban -> 'ban a specific char '
-//2b29: FREE
+//2b29: Incoming, chrif_save_delta_nak -> char-server has no base for a delta save, the status is sent complete
 //2b2a: Outgoing, chrif_req_charunban -> 'unban a specific char '
 //2b2b: Incoming, chrif_parse_ack_vipActive -> vip info result
-//2b2c: FREE
+//2b2c: Outgoing, chrif_save_delta -> 'charsave of char XY account XY (changed byte ranges since the last save)'
 //2b2d: Outgoing, chrif_bsdata_request -> request bonus_script for pc_authok'ed char.
 //2b2e: Outgoing, chrif_bsdata_save -> Send bonus_script of player for saving.
 //2b2f: Incoming, chrif_bsdata_received -> received bonus_script of player for loading.
@@ -119,6 +119,8 @@ int other_mapserver_count=0; //Holds count of how many other map servers are onl
 #define CHECK_INTERVAL 3600000
 //Interval at which map server sends number of connected users. [Skotlex]
 #define UPDATE_INTERVAL 10000
+//Unchanged bytes up to which two changed ranges of a delta save are merged
+#define CHRIF_DELTA_GAP 8
 //This define should spare writing the check in every function. [Skotlex]
 #define chrif_check(a) { if(!chrif_isconnected()) return a; }
 
@@ -279,6 +281,107 @@ int chrif_isconnected(void) {
 	return (char_fd > 0 && session[char_fd] != NULL && chrif_state == 2);
 }
 
+/**
+ * Sends the changes of a character's status since its last save (0x2b2c).
+ * Every changed byte range is sent as offset, length and data. Ranges closer than
+ * CHRIF_DELTA_GAP bytes are merged, a range header costs 4 bytes.
+ * @param sd: player
+ * @param status: status to save
+ * @return false when the delta would not be smaller than the complete status
+ */
+static bool chrif_save_delta(struct map_session_data *sd, const struct mmo_charstatus *status) {
+	const uint8 *cur = (const uint8 *)status, *old = (const uint8 *)sd->save_base;
+	size_t size = sizeof(struct mmo_charstatus), full_len = size + 13, len = 13;
+
+	WFIFOHEAD(char_fd, full_len);
+
+	for (size_t i = 0; i < size; ) {
+		if (cur[i] == old[i]) {
+			i++;
+			continue;
+		}
+
+		size_t start = i, end = i + 1;
+
+		for (size_t j = end; j < size && j - end < CHRIF_DELTA_GAP; j++) {
+			if (cur[j] != old[j])
+				end = j + 1;
+		}
+
+		if (len + 4 + (end - start) >= full_len)
+			return false;
+
+		WFIFOW(char_fd, len) = (uint16)start;
+		WFIFOW(char_fd, len + 2) = (uint16)(end - start);
+		memcpy(WFIFOP(char_fd, len + 4), cur + start, end - start);
+		len += 4 + (end - start);
+		i = end;
+	}
+
+	WFIFOW(char_fd, 0) = 0x2b2c;
+	WFIFOW(char_fd, 2) = (uint16)len;
+	WFIFOL(char_fd, 4) = sd->status.account_id;
+	WFIFOL(char_fd, 8) = sd->status.char_id;
+	WFIFOB(char_fd, 12) = 0; // never a final save
+	WFIFOSET(char_fd, len);
+	return true;
+}
+
+/**
+ * Sends a character's status, as delta (0x2b2c) when there is a base from the last save, otherwise complete (0x2b01).
+ * @param sd: player
+ * @param flag: save flag types, see chrif_save
+ */
+static void chrif_save_status(struct map_session_data *sd, int flag) {
+	uint16 mmo_charstatus_len = 0;
+	struct mmo_charstatus status;
+
+	// Copy the whole status
+	memcpy( &status, &sd->status, sizeof( struct mmo_charstatus ) );
+
+	// If the user is on a instance map, we have to fake his current position
+	if( map_getmapdata(sd->bl.m)->instance_id ){
+		// Change his current position to his savepoint
+		memcpy( &status.last_point, &status.save_point, sizeof( struct point ) );
+	}
+
+	// Saves that end the session on this map-server are always complete
+	if( (flag&CSAVE_QUITTING) || sd->save_base == NULL || !chrif_save_delta(sd, &status) ){
+		mmo_charstatus_len = sizeof(sd->status) + 13;
+		WFIFOHEAD(char_fd, mmo_charstatus_len);
+		WFIFOW(char_fd,0) = 0x2b01;
+		WFIFOW(char_fd,2) = mmo_charstatus_len;
+		WFIFOL(char_fd,4) = sd->status.account_id;
+		WFIFOL(char_fd,8) = sd->status.char_id;
+		WFIFOB(char_fd,12) = (flag&CSAVE_QUIT) ? 1 : 0; //Flag to tell char-server this character is quitting.
+		memcpy( WFIFOP( char_fd, 13 ), &status, sizeof( struct mmo_charstatus ) );
+		WFIFOSET(char_fd, WFIFOW(char_fd,2));
+	}
+
+	if( sd->save_base == NULL )
+		sd->save_base = (struct mmo_charstatus *)aMalloc(sizeof(struct mmo_charstatus));
+	memcpy( sd->save_base, &status, sizeof( struct mmo_charstatus ) );
+}
+
+/**
+ * The char-server has no base for a delta save of this character (0x2b29).
+ * The dropped delta is replaced right away by a complete save of the current status.
+ */
+static void chrif_save_delta_nak(int fd) {
+	struct map_session_data *sd = map_charid2sd(RFIFOL(fd, 6));
+
+	if (sd == NULL)
+		return;
+
+	if (sd->save_base) {
+		aFree(sd->save_base);
+		sd->save_base = NULL;
+	}
+
+	pc_makesavestatus(sd);
+	chrif_save_status(sd, CSAVE_NORMAL);
+}
+
 /**
  * Saves character data.
  * @param sd: Player data
@@ -291,8 +394,6 @@ int chrif_isconnected(void) {
  *  CSAVE_CART: Character changed cart data
  */
 int chrif_save(struct map_session_data *sd, int flag) {
-	uint16 mmo_charstatus_len = 0;
-
 	nullpo_retr(-1, sd);
 
 	pc_makesavestatus(sd);
@@ -310,18 +411,27 @@ int chrif_save(struct map_session_data *sd, int flag) {
 
 	chrif_bsdata_save(sd, ((flag&CSAVE_QUITTING) && !(flag&CSAVE_AUTOTRADE)));
 
-	if (sd->storage.dirty)
-		storage_storagesave(sd);
-	if (flag&CSAVE_INVENTORY)
-		intif_storage_save(sd,&sd->inventory);
-	if (flag&CSAVE_CART)
-		intif_storage_save(sd,&sd->cart);
+	// Item saves are skipped while the char-server already has the same items
+	if (sd->storage.dirty) {
+		if (intif_storage_changed(sd, &sd->storage))
+			storage_storagesave(sd);
+		else
+			sd->storage.dirty = false;
+	}
+	if ((flag&CSAVE_INVENTORY) && intif_storage_changed(sd, &sd->inventory))
+		intif_storage_save(sd, &sd->inventory);
+	if ((flag&CSAVE_CART) && intif_storage_changed(sd, &sd->cart))
+		intif_storage_save(sd, &sd->cart);
 
 	//For data sync
 	if (sd->state.storage_flag == 2)
 		storage_guild_storagesave(sd->status.account_id, sd->status.guild_id, flag);
-	if (sd->premiumStorage.dirty)
-		storage_premiumStorage_save(sd);
+	if (sd->premiumStorage.dirty) {
+		if (intif_storage_changed(sd, &sd->premiumStorage))
+			storage_premiumStorage_save(sd);
+		else
+			sd->premiumStorage.dirty = false;
+	}
 
 	if (flag&CSAVE_QUITTING)
 		sd->state.storage_flag = 0; //Force close it.
@@ -330,30 +440,7 @@ int chrif_save(struct map_session_data *sd, int flag) {
 	if (sd->vars_dirty)
 		intif_saveregistry(sd);
 
-	mmo_charstatus_len = sizeof(sd->status) + 13;
-	WFIFOHEAD(char_fd, mmo_charstatus_len);
-	WFIFOW(char_fd,0) = 0x2b01;
-	WFIFOW(char_fd,2) = mmo_charstatus_len;
-	WFIFOL(char_fd,4) = sd->status.account_id;
-	WFIFOL(char_fd,8) = sd->status.char_id;
-	WFIFOB(char_fd,12) = (flag&CSAVE_QUIT) ? 1 : 0; //Flag to tell char-server this character is quitting.
-
-	// If the user is on a instance map, we have to fake his current position
-	if( map_getmapdata(sd->bl.m)->instance_id ){
-		struct mmo_charstatus status;
-
-		// Copy the whole status
-		memcpy( &status, &sd->status, sizeof( struct mmo_charstatus ) );
-		// Change his current position to his savepoint
-		memcpy( &status.last_point, &status.save_point, sizeof( struct point ) );
-		// Copy the copied status into the packet
-		memcpy( WFIFOP( char_fd, 13 ), &status, sizeof( struct mmo_charstatus ) );
-	} else {
-		// Copy the whole status into the packet
-		memcpy( WFIFOP( char_fd, 13 ), &sd->status, sizeof( struct mmo_charstatus ) );
-	}
-
-	WFIFOSET(char_fd, WFIFOW(char_fd,2));
+	chrif_save_status(sd, flag);
 
 	if( sd->status.pet_id > 0 && sd->pd )
 		intif_save_petdata(sd->status.account_id,&sd->pd->pet);
@@ -1522,6 +1609,19 @@ void chrif_on_disconnect(void) {
 		ShowWarning("Connection to Char Server lost.\n\n");
 	chrif_connected = 0;
 
+	// The char-server may have lost the bases of delta saves and unprocessed saves, the next saves are complete
+	struct s_mapiterator* iter = mapit_getallusers();
+	struct map_session_data* sd;
+
+	for( sd = (TBL_PC*)mapit_first(iter); mapit_exists(iter); sd = (TBL_PC*)mapit_next(iter) ){
+		if( sd->save_base ){
+			aFree(sd->save_base);
+			sd->save_base = NULL;
+		}
+		intif_storage_freebase(sd);
+	}
+	mapit_free(iter);
+
 	other_mapserver_count = 0; //Reset counter. We receive ALL maps from all map-servers on reconnect.
 	map_eraseallipport();
 
@@ -1831,6 +1931,7 @@ int chrif_parse(int fd) {
 			case 0x2b24: chrif_keepalive_ack(fd); break;
 			case 0x2b25: chrif_deadopt(RFIFOL(fd,2), RFIFOL(fd,6), RFIFOL(fd,10)); break;
 			case 0x2b27: chrif_authfail(fd); break;
+			case 0x2b29: chrif_save_delta_nak(fd); break;
 			case 0x2b2b: chrif_parse_ack_vipActive(fd); break;
 			case 0x2b2f: chrif_bsdata_received(fd); break;
 			default:
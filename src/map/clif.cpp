@@ -3,6 +3,8 @@
 
 #include "clif.hpp"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
@@ -190,6 +192,11 @@ struct s_packet_db packet_db[MAX_PACKET_DB + 1];
 int packet_db_ack[MAX_ACK_FUNC + 1];
 unsigned long color_table[COLOR_MAX];
 
+/* packet profiler */
+#define PACKET_PROFILE_FILE "log/packet_profile.csv"
+static struct s_packet_profile packet_profile[PACKET_PROFILE_MAX][MAX_PACKET_DB + 1];
+static int packet_profile_sample = 0;
+
 #include "clif_obfuscation.hpp"
 static bool clif_session_isValid(struct map_session_data *sd);
 
@@ -524,11 +531,123 @@ static int clif_send_sub(struct block_list *bl, va_list ap)
 	return 0;
 }
 
+/*==========================================
+ * Packet profiler
+ *------------------------------------------*/
+
+/**
+ * Counts a packet in the profiler and decides whether its processing time should be measured.
+ * Only every packet_profile_rate-th packet is timed to keep the overhead low.
+ * @param dir: Packet direction
+ * @param cmd: Packet ID
+ * @param len: Packet length
+ * @return True if the caller should time the packet
+ */
+static inline bool clif_packet_profile_count( enum e_packet_profile_dir dir, int cmd, int len ){
+	if( battle_config.packet_profile_rate <= 0 || cmd < 0 || cmd > MAX_PACKET_DB )
+		return false;
+
+	struct s_packet_profile* profile = &packet_profile[dir][cmd];
+
+	profile->count++;
+	profile->bytes += len;
+
+	if( ++packet_profile_sample < battle_config.packet_profile_rate )
+		return false;
+
+	packet_profile_sample = 0;
+	return true;
+}
+
+/**
+ * Adds the time elapsed since start to the timed calls of a packet.
+ * @param dir: Packet direction
+ * @param cmd: Packet ID
+ * @param start: Time at which the processing started
+ */
+static inline void clif_packet_profile_time( enum e_packet_profile_dir dir, int cmd, std::chrono::steady_clock::time_point start ){
+	struct s_packet_profile* profile = &packet_profile[dir][cmd];
+	uint64 elapsed = (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - start ).count();
+
+	profile->samples++;
+	profile->time += elapsed;
+	profile->max = std::max( profile->max, elapsed );
+}
+
+/**
+ * Returns the profiler data of a packet.
+ * @param dir: Packet direction
+ * @param cmd: Packet ID
+ * @return Profiler data or nullptr for invalid packet IDs
+ */
+const struct s_packet_profile* clif_packet_profile_get( enum e_packet_profile_dir dir, uint16 cmd ){
+	if( dir >= PACKET_PROFILE_MAX || cmd > MAX_PACKET_DB )
+		return nullptr;
+
+	return &packet_profile[dir][cmd];
+}
+
+/// Clears all profiler data.
+void clif_packet_profile_reset( void ){
+	memset( packet_profile, 0, sizeof( packet_profile ) );
+	packet_profile_sample = 0;
+}
+
+/**
+ * Appends the current profiler data as CSV rows to a file.
+ * Counters are cumulative since startup or the last reset.
+ * @param filename: File to append to
+ * @return True on success
+ */
+bool clif_packet_profile_dump( const char* filename ){
+	FILE* fp = fopen( filename, "a" );
+
+	if( fp == nullptr ){
+		ShowError( "clif_packet_profile_dump: Could not open '%s' for writing.\n", filename );
+		return false;
+	}
+
+	// Write the header if the file is new
+	if( ftell( fp ) == 0 )
+		fprintf( fp, "time,direction,packet,count,bytes,samples,total_us,avg_us,max_us\n" );
+
+	time_t now = time( nullptr );
+
+	for( int dir = PACKET_PROFILE_RECV; dir < PACKET_PROFILE_MAX; dir++ ){
+		for( int cmd = 0; cmd <= MAX_PACKET_DB; cmd++ ){
+			struct s_packet_profile* profile = &packet_profile[dir][cmd];
+
+			if( profile->count == 0 )
+				continue;
+
+			fprintf( fp, "%" PRId64 ",%s,0x%04x,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+				(int64)now, dir == PACKET_PROFILE_RECV ? "recv" : "send", cmd, profile->count, profile->bytes, profile->samples,
+				profile->time / 1000, profile->samples ? profile->time / profile->samples / 1000 : 0, profile->max / 1000 );
+		}
+	}
+
+	fclose( fp );
+	return true;
+}
+
+/// Periodically dumps the profiler data, see packet_profile_dump_interval.
+static TIMER_FUNC(clif_packet_profile_timer){
+	int interval = battle_config.packet_profile_dump_interval;
+
+	if( battle_config.packet_profile_rate > 0 && interval > 0 )
+		clif_packet_profile_dump( PACKET_PROFILE_FILE );
+	else
+		interval = 60; // Check again later, the configuration might have been reloaded
+
+	add_timer( gettick() + interval * 1000, clif_packet_profile_timer, 0, 0 );
+	return 0;
+}
+
 /*==========================================
  * Packet Delegation (called on all packets that require data to be sent to more than one client)
  * functions that are sent solely to one use whose ID it posses use WFIFOSET
  *------------------------------------------*/
-int clif_send(const uint8* buf, int len, struct block_list* bl, enum send_target type)
+static int clif_send_target(const uint8* buf, int len, struct block_list* bl, enum send_target type)
 {
 	int i;
 	struct map_session_data *sd, *tsd;
@@ -571,7 +690,7 @@ int clif_send(const uint8* buf, int len, struct block_list* bl, enum send_target
 	case AREA:
 	case AREA_WOSC:
 		if (sd && bl->prev == NULL) //Otherwise source misses the packet.[Skotlex]
-			clif_send (buf, len, bl, SELF);
+			clif_send_target (buf, len, bl, SELF);
 	case AREA_WOC:
 	case AREA_WOS:
 		map_foreachinallarea(clif_send_sub, bl->m, bl->x-AREA_SIZE, bl->y-AREA_SIZE, bl->x+AREA_SIZE, bl->y+AREA_SIZE,
@@ -800,6 +919,20 @@ int clif_send(const uint8* buf, int len, struct block_list* bl, enum send_target
 	return 0;
 }
 
+int clif_send(const uint8* buf, int len, struct block_list* bl, enum send_target type)
+{
+	int cmd = ( len >= 2 ) ? RBUFW(buf, 0) : -1;
+
+	if( !clif_packet_profile_count( PACKET_PROFILE_SEND, cmd, len ) )
+		return clif_send_target(buf, len, bl, type);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int ret = clif_send_target(buf, len, bl, type);
+
+	clif_packet_profile_time( PACKET_PROFILE_SEND, cmd, start );
+	return ret;
+}
+
 
 /// Notifies the client, that it's connection attempt was accepted.
 /// 0073 <start time>.L <position>.3B <x size>.B <y size>.B (ZC_ACCEPT_ENTER)
@@ -2361,7 +2494,7 @@ void clif_parse_NPCMarketPurchase(int fd, struct map_session_data *sd) {
 	len = RFIFOW(fd,info->pos[0]);
 	n = (len-4) / 6;
 
-	CREATE(item_list, struct s_npc_buy_list, n);
+	TICK_CREATE(item_list, struct s_npc_buy_list, n);
 	for (i = 0; i < n; i++) {
 		item_list[i].nameid = RFIFOW(fd,info->pos[1]+i*6);
 		item_list[i].qty    = (uint16)min(RFIFOL(fd,info->pos[2]+i*6),USHRT_MAX);
@@ -2369,7 +2502,6 @@ void clif_parse_NPCMarketPurchase(int fd, struct map_session_data *sd) {
 
 	res = npc_buylist(sd, n, item_list);
 	clif_npc_market_purchase_ack(sd, res, n, item_list);
-	aFree(item_list);
 #endif
 }
 
@@ -2963,50 +3095,82 @@ void clif_item_sub(unsigned char *buf, int n, int idx, struct item *it, struct i
 
 
 
-void clif_favorite_item(struct map_session_data* sd, unsigned short index);
-//Unified inventory function which sends all of the inventory (requires two packets, one for equipable items and one for stackable ones. [Skotlex]
-void clif_inventorylist(struct map_session_data *sd) {
-	int i,n,ne,arrow=-1;
-	unsigned char *buf;
-	unsigned char *bufe;
-
 #if PACKETVER < 5
-	const int s = 10; //Entry size
+#define INVENTORYLIST_SIZE 10 //Entry size
 #elif PACKETVER < 20080102
-	const int s = 18;
+#define INVENTORYLIST_SIZE 18
 #elif PACKETVER < 20120925
-	const int s = 22;
+#define INVENTORYLIST_SIZE 22
 #else
-	const int s = 24;
+#define INVENTORYLIST_SIZE 24
 #endif
 #if PACKETVER < 20071002
-	const int se = 20;
+#define INVENTORYLIST_EQUIP_SIZE 20
 #elif PACKETVER < 20100629
-	const int se = 26;
+#define INVENTORYLIST_EQUIP_SIZE 26
 #elif PACKETVER < 20120925
-	const int se = 28;
+#define INVENTORYLIST_EQUIP_SIZE 28
 #elif PACKETVER < 20150225
-	const int se = 31;
+#define INVENTORYLIST_EQUIP_SIZE 31
 #else
-	const int se = 57;
+#define INVENTORYLIST_EQUIP_SIZE 57
 #endif
 
-	buf = (unsigned char*)aMalloc(MAX_INVENTORY * s + 4);
-	bufe = (unsigned char*)aMalloc(MAX_INVENTORY * se + 4);
+/// Last encoded clif_inventorylist entry of an inventory index.
+/// The entry is reused as long as the item, its data and equip point are unchanged,
+/// so warping players with big inventories don't encode every item again.
+struct s_inventorylist_cache {
+	struct item item;
+	struct item_data *data;
+	int equip;
+	unsigned char buf[INVENTORYLIST_SIZE > INVENTORYLIST_EQUIP_SIZE ? INVENTORYLIST_SIZE : INVENTORYLIST_EQUIP_SIZE];
+};
+
+void clif_favorite_item(struct map_session_data* sd, unsigned short index);
+//Unified inventory function which sends all of the inventory (requires two packets, one for equipable items and one for stackable ones. [Skotlex]
+void clif_inventorylist(struct map_session_data *sd) {
+	int i,n,ne,arrow=-1;
+	unsigned char *buf;
+	unsigned char *bufe;
+	const int s = INVENTORYLIST_SIZE;
+	const int se = INVENTORYLIST_EQUIP_SIZE;
+
+	buf = (unsigned char*)aTickMalloc(MAX_INVENTORY * s + 4);
+	bufe = (unsigned char*)aTickMalloc(MAX_INVENTORY * se + 4);
+
+	if( sd->inventorylist_cache == NULL )
+		CREATE(sd->inventorylist_cache, struct s_inventorylist_cache, MAX_INVENTORY);
 
 	for( i = 0, n = 0, ne = 0; i < MAX_INVENTORY; i++ )
 	{
-		if( sd->inventory.u.items_inventory[i].nameid <=0 || sd->inventory_data[i] == NULL )
+		struct item *it = &sd->inventory.u.items_inventory[i];
+		struct item_data *id = sd->inventory_data[i];
+		struct s_inventorylist_cache *entry = &sd->inventorylist_cache[i];
+		bool stackable;
+		int equip;
+
+		if( it->nameid <=0 || id == NULL )
 			continue;
 
-		if( !itemdb_isstackable2(sd->inventory_data[i]) )
+		stackable = itemdb_isstackable2(id);
+		equip = stackable ? -2 : pc_equippoint(sd,i);
+
+		if( entry->data != id || entry->equip != equip || memcmp(&entry->item, it, sizeof(struct item)) != 0 )
+		{
+			clif_item_sub(entry->buf, 0, i+2, it, id, equip);
+			memcpy(&entry->item, it, sizeof(struct item));
+			entry->data = id;
+			entry->equip = equip;
+		}
+
+		if( !stackable )
 		{	//Non-stackable (Equippable)
-			clif_item_sub(bufe, ne*se+4, i+2, &sd->inventory.u.items_inventory[i], sd->inventory_data[i], pc_equippoint(sd,i));
+			memcpy(bufe + ne*se+4, entry->buf, se);
 			ne++;
 		}
 		else { //Stackable.
-			clif_item_sub(buf, n*s+4,i+2, &sd->inventory.u.items_inventory[i], sd->inventory_data[i], -2);
-			if( sd->inventory_data[i]->equip == EQP_AMMO && sd->inventory.u.items_inventory[i].equip )
+			memcpy(buf + n*s+4, entry->buf, s);
+			if( id->equip == EQP_AMMO && it->equip )
 				arrow=i;
 			n++;
 		}
@@ -3049,9 +3213,6 @@ void clif_inventorylist(struct map_session_data *sd) {
 			clif_favorite_item(sd, i);
 	}
 #endif
-
-	if( buf ) aFree(buf);
-	if( bufe ) aFree(bufe);
 }
 
 //Required when items break/get-repaired. Only sends equippable item list.
@@ -3145,8 +3306,8 @@ void clif_storagelist(struct map_session_data* sd, struct item* items, int items
 	const int cmde = 0xa10;
 #endif
 
-	buf = (unsigned char*)aMalloc(items_length * s + sidx);
-	bufe = (unsigned char*)aMalloc(items_length * se + sidxe);
+	buf = (unsigned char*)aTickMalloc(items_length * s + sidx);
+	bufe = (unsigned char*)aTickMalloc(items_length * se + sidxe);
 
 	for( i = 0, n = 0, ne = 0; i < items_length; i++ )
 	{
@@ -3197,9 +3358,6 @@ void clif_storagelist(struct map_session_data* sd, struct item* items, int items
 #endif
 		WFIFOSET(sd->fd,WFIFOW(sd->fd,2));
 	}
-
-	if( buf ) aFree(buf);
-	if( bufe ) aFree(bufe);
 }
 
 void clif_cartlist(struct map_session_data *sd)
@@ -3229,8 +3387,8 @@ void clif_cartlist(struct map_session_data *sd)
 	const int cmd = 57;
 #endif
 
-	buf = (unsigned char*)aMalloc(MAX_CART * s + 4);
-	bufe = (unsigned char*)aMalloc(MAX_CART * cmd + 4);
+	buf = (unsigned char*)aTickMalloc(MAX_CART * s + 4);
+	bufe = (unsigned char*)aTickMalloc(MAX_CART * cmd + 4);
 
 	for( i = 0, n = 0, ne = 0; i < MAX_CART; i++ )
 	{
@@ -3274,9 +3432,6 @@ void clif_cartlist(struct map_session_data *sd)
 		WBUFW(bufe,2)=4+ne*cmd;
 		clif_send(bufe, WBUFW(bufe,2), &sd->bl, SELF);
 	}
-
-	if( buf ) aFree(buf);
-	if( bufe ) aFree(bufe);
 }
 
 
@@ -20556,7 +20711,7 @@ void clif_hat_effects( struct map_session_data* sd, struct block_list* bl, enum
 
 	len = 9 + tsd->hatEffectCount * 2;
 
-	buf = (unsigned char*)aMalloc( len );
+	buf = (unsigned char*)aTickMalloc( len );
 
 	WBUFW(buf,0) = 0xa3b;
 	WBUFW(buf,2) = len;
@@ -20568,8 +20723,6 @@ void clif_hat_effects( struct map_session_data* sd, struct block_list* bl, enum
 	}
 
 	clif_send(buf, len,tbl,target);
-
-	aFree(buf);
 #endif
 }
 
@@ -21937,6 +22090,12 @@ static int clif_parse(int fd)
 		sd->cryptKey = ((sd->cryptKey * clif_cryptKey[1]) + clif_cryptKey[2]) & 0xFFFFFFFF; // Update key for the next packet
 #endif
 
+	bool profile = clif_packet_profile_count( PACKET_PROFILE_RECV, cmd, packet_len );
+	std::chrono::steady_clock::time_point profile_start;
+
+	if( profile )
+		profile_start = std::chrono::steady_clock::now();
+
 	if( packet_db[cmd].func == clif_parse_debug )
 		packet_db[cmd].func(fd, sd);
 	else if( packet_db[cmd].func != NULL ) {
@@ -21951,6 +22110,10 @@ static int clif_parse(int fd)
 #ifdef DUMP_UNKNOWN_PACKET
 	else DumpUnknown(fd,sd,cmd,packet_len);
 #endif
+
+	if( profile )
+		clif_packet_profile_time( PACKET_PROFILE_RECV, cmd, profile_start );
+
 	RFIFOSKIP(fd, packet_len);
 	}; // main loop end
 
@@ -22036,6 +22199,9 @@ void do_init_clif(void) {
 
 	add_timer_func_list(clif_clearunit_delayed_sub, "clif_clearunit_delayed_sub");
 	add_timer_func_list(clif_delayquit, "clif_delayquit");
+	add_timer_func_list(clif_packet_profile_timer, "clif_packet_profile_timer");
+
+	add_timer(gettick() + 60000, clif_packet_profile_timer, 0, 0);
 
 	delay_clearunit_ers = ers_new(sizeof(struct block_list),"clif.cpp::delay_clearunit_ers",ERS_OPT_CLEAR);
 }
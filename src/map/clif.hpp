@@ -945,6 +945,26 @@ void clif_quest_show_event(struct map_session_data *sd, struct block_list *bl, e
 void clif_displayexp(struct map_session_data *sd, expType exp, char type, bool quest, bool lost);
 
 int clif_send(const uint8* buf, int len, struct block_list* bl, enum send_target type);
+
+// Packet profiler
+enum e_packet_profile_dir : uint8 {
+	PACKET_PROFILE_RECV = 0,	// Client packets handled by clif_parse
+	PACKET_PROFILE_SEND,		// Packets dispatched through clif_send
+	PACKET_PROFILE_MAX
+};
+
+struct s_packet_profile {
+	uint64 count;	// Number of packets
+	uint64 bytes;	// Total packet length
+	uint64 samples;	// Number of timed calls
+	uint64 time;	// Cumulative time of the timed calls in nanoseconds
+	uint64 max;		// Longest timed call in nanoseconds
+};
+
+const struct s_packet_profile* clif_packet_profile_get(enum e_packet_profile_dir dir, uint16 cmd);
+void clif_packet_profile_reset(void);
+bool clif_packet_profile_dump(const char* filename);
+
 void do_init_clif(void);
 void do_final_clif(void);
 
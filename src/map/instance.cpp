@@ -3,6 +3,7 @@
 
 #include "instance.hpp"
 
+#include <algorithm>
 #include <stdlib.h>
 #include <yaml-cpp/yaml.h>
 
@@ -34,11 +35,15 @@ struct s_instance_wait {
 } instance_wait;
 
 #define INSTANCE_INTERVAL	60000	// Interval used to check when an instance is to be destroyed (ms)
+#define INSTANCE_POOL_INTERVAL	500	// Interval used to build one missing pooled instance (ms)
+#define INSTANCE_POOL_RETRY	60000	// Delay before building a pooled instance is retried after a failure (ms)
 
 int16 instance_start = 0; // Instance MapID start
 int instance_count = 1; // Total created instances
 
 std::unordered_map<int, std::shared_ptr<s_instance_data>> instances;
+std::unordered_map<int32, std::deque<int>> instance_pool; // Instance DB ID -> pre-built instances
+static std::unordered_map<int32, t_tick> instance_pool_retry; // Instance DB ID -> tick the pool is filled again after a failure
 
 const std::string InstanceDatabase::getDefaultLocation() {
 	return std::string(db_path) + "/instance_db.yml";
@@ -111,6 +116,18 @@ uint64 InstanceDatabase::parseBodyNode(const YAML::Node &node) {
 			instance->timeout = 300;
 	}
 
+	if (this->nodeExists(node, "PoolSize")) {
+		uint16 pool;
+
+		if (!this->asUInt16(node, "PoolSize", pool))
+			return 0;
+
+		instance->pool_size = pool;
+	} else {
+		if (!exists)
+			instance->pool_size = 0;
+	}
+
 	/*
 	if (this->nodeExists(node, "Destroyable")) {
 		bool destroy;
@@ -504,24 +521,147 @@ static int instance_addnpc_sub(struct block_list *bl, va_list ap)
 }
 
 /**
- * Add an NPC to an instance
+ * Duplicate the NPCs of the source maps onto the instance maps
  * @param idata: Instance data
  */
-void instance_addnpc(std::shared_ptr<s_instance_data> idata)
+static void instance_duplicatenpc(std::shared_ptr<s_instance_data> idata)
 {
-	// First add the NPCs
 	for (const auto &it : idata->map) {
 		struct map_data *mapdata = map_getmapdata(it.m);
 
 		map_foreachinallarea(instance_addnpc_sub, it.src_m, 0, 0, mapdata->xs, mapdata->ys, BL_NPC, it.m);
 	}
+}
 
-	// Now run their OnInstanceInit
+/**
+ * Run the OnInstanceInit events on all instance maps
+ * @param idata: Instance data
+ */
+static void instance_initnpc(std::shared_ptr<s_instance_data> idata)
+{
 	for (const auto &it : idata->map) {
 		struct map_data *mapdata = map_getmapdata(it.m);
 
 		map_foreachinallarea(instance_npcinit, it.m, 0, 0, mapdata->xs, mapdata->ys, BL_NPC, it.m);
-  }
+	}
+}
+
+/**
+ * Add an NPC to an instance
+ * @param idata: Instance data
+ */
+void instance_addnpc(std::shared_ptr<s_instance_data> idata)
+{
+	// First add the NPCs
+	instance_duplicatenpc(idata);
+
+	// Now run their OnInstanceInit
+	instance_initnpc(idata);
+}
+
+/**
+ * Creates the maps of an instance
+ * @param idata: Instance data
+ * @param instance_id: Instance ID
+ * @param db: Instance DB entry
+ * @return True on success or false on failure
+ */
+static bool instance_createmaps(std::shared_ptr<s_instance_data> idata, int instance_id, std::shared_ptr<s_instance_db> db)
+{
+	int16 m;
+
+	// Add initial map
+	if ((m = map_addinstancemap(db->enter.map, instance_id)) < 0) {
+		ShowError("instance_addmap: Failed to create initial map for instance '%s' (%d).\n", db->name.c_str(), instance_id);
+		return false;
+	}
+
+	struct s_instance_map entry;
+
+	entry.m = m;
+	entry.src_m = db->enter.map;
+	idata->map.push_back(entry);
+
+	// Add extra maps (if any)
+	for (const auto &it : db->maplist) {
+		if ((m = map_addinstancemap(it, instance_id)) < 0) { // An error occured adding a map
+			ShowError("instance_addmap: No maps added to instance '%s' (%d).\n", db->name.c_str(), instance_id);
+			return false;
+		} else {
+			entry.m = m;
+			entry.src_m = it;
+			idata->map.push_back(entry);
+		}
+	}
+
+	return true;
+}
+
+/**
+ * Builds the maps and NPCs of an instance ahead of time for instance_create
+ * @param db: Instance DB entry
+ * @return True on success or false on failure
+ */
+static bool instance_pool_add(std::shared_ptr<s_instance_db> db)
+{
+	if (instance_count <= 0)
+		return false;
+
+	int instance_id = instance_count++;
+	std::shared_ptr<s_instance_data> entry = std::make_shared<s_instance_data>();
+
+	entry->id = db->id;
+	entry->state = INSTANCE_POOL;
+	entry->mode = IM_NONE;
+	entry->regs.vars = i64db_alloc(DB_OPT_RELEASE_DATA);
+	entry->regs.arrays = nullptr;
+	instances.insert({ instance_id, entry });
+
+	if (!instance_createmaps(entry, instance_id, db)) {
+		instance_destroy(instance_id);
+		if (instance_id == instance_count - 1) // Never handed out, the ID can be used again
+			instance_count--;
+		return false;
+	}
+
+	// OnInstanceInit is run once the instance is handed out
+	instance_duplicatenpc(entry);
+	instance_pool[db->id].push_back(instance_id);
+
+	return true;
+}
+
+/**
+ * Keeps the instance pools filled, one instance is built or removed per call
+ * An instance that fails to build is skipped for INSTANCE_POOL_RETRY ms so the other pools are still filled.
+ */
+static TIMER_FUNC(instance_pool_timer){
+	for (const auto &it : instance_db) {
+		std::shared_ptr<s_instance_db> db = it.second;
+		std::deque<int> *pool = util::umap_find(instance_pool, db->id);
+		size_t count = pool ? pool->size() : 0;
+
+		if (count < db->pool_size) {
+			t_tick *retry = util::umap_find(instance_pool_retry, db->id);
+
+			if (retry && DIFF_TICK(tick, *retry) < 0)
+				continue;
+			if (instance_pool_add(db)) {
+				instance_pool_retry.erase(db->id);
+				return 0;
+			}
+			ShowWarning("instance_pool_timer: Failed to build a pooled instance of '%s', retrying in %d seconds.\n", db->name.c_str(), INSTANCE_POOL_RETRY / 1000);
+			instance_pool_retry[db->id] = tick + INSTANCE_POOL_RETRY;
+			continue;
+		}
+
+		if (count > db->pool_size) { // PoolSize was lowered by a reload
+			instance_destroy(pool->back());
+			return 0;
+		}
+	}
+
+	return 0;
 }
 
 /**
@@ -584,18 +724,29 @@ int instance_create(int owner_id, const char *name, e_instance_mode mode) {
 			return -2;
 	}
 
-	if (instance_count <= 0)
-		return -4;
+	std::deque<int> *pool = util::umap_find(instance_pool, db->id);
+	int instance_id;
+	std::shared_ptr<s_instance_data> entry;
 
-	int instance_id = instance_count++;
-	std::shared_ptr<s_instance_data> entry = std::make_shared<s_instance_data>();
+	if (pool && !pool->empty()) { // Hand out a pre-built instance, instance_addmap only runs its OnInstanceInit
+		instance_id = pool->front();
+		pool->pop_front();
+		entry = util::umap_find(instances, instance_id);
+		entry->state = INSTANCE_IDLE;
+	} else {
+		if (instance_count <= 0)
+			return -4;
+
+		instance_id = instance_count++;
+		entry = std::make_shared<s_instance_data>();
+		entry->id = db->id;
+		entry->regs.vars = i64db_alloc(DB_OPT_RELEASE_DATA);
+		entry->regs.arrays = nullptr;
+		instances.insert({ instance_id, entry });
+	}
 
-	entry->id = db->id;
 	entry->owner_id = owner_id;
 	entry->mode = mode;
-	entry->regs.vars = i64db_alloc(DB_OPT_RELEASE_DATA);
-	entry->regs.arrays = nullptr;
-	instances.insert({ instance_id, entry });
 
 	switch(mode) {
 		case IM_CHAR:
@@ -649,34 +800,16 @@ int instance_addmap(int instance_id) {
 	idata->idle_limit = static_cast<unsigned int>(time(nullptr)) + db->timeout;
 	idata->idle_timer = add_timer(gettick() + db->timeout * 1000, instance_delete_timer, instance_id, 0);
 
-	int16 m;
-
-	// Add initial map
-	if ((m = map_addinstancemap(db->enter.map, instance_id)) < 0) {
-		ShowError("instance_addmap: Failed to create initial map for instance '%s' (%d).\n", db->name.c_str(), instance_id);
-		return 0;
-	}
-
-	struct s_instance_map entry;
-
-	entry.m = m;
-	entry.src_m = db->enter.map;
-	idata->map.push_back(entry);
-
-	// Add extra maps (if any)
-	for (const auto &it : db->maplist) {
-		if ((m = map_addinstancemap(it, instance_id)) < 0) { // An error occured adding a map
-			ShowError("instance_addmap: No maps added to instance '%s' (%d).\n", db->name.c_str(), instance_id);
+	// Pre-built instances already have their maps and NPCs
+	if (idata->map.empty()) {
+		if (!instance_createmaps(idata, instance_id, db))
 			return 0;
-		} else {
-			entry.m = m;
-			entry.src_m = it;
-			idata->map.push_back(entry);
-		}
+
+		instance_duplicatenpc(idata);
 	}
 
-	// Create NPCs on all maps
-	instance_addnpc(idata);
+	// Run OnInstanceInit on all maps
+	instance_initnpc(idata);
 
 	switch(idata->mode) {
 		case IM_NONE:
@@ -796,6 +929,11 @@ bool instance_destroy(int instance_id)
 				break;
 			}
 		}
+	} else if(idata->state == INSTANCE_POOL) {
+		std::deque<int> *pool = util::umap_find(instance_pool, idata->id);
+
+		if (pool)
+			pool->erase(std::remove(pool->begin(), pool->end(), instance_id), pool->end());
 	} else {
 		unsigned int now = static_cast<unsigned int>(time(nullptr));
 
@@ -805,14 +943,15 @@ bool instance_destroy(int instance_id)
 			type = IN_DESTROY_ENTER_TIMEOUT;
 		else
 			type = IN_DESTROY_USER_REQUEST;
+	}
 
-		// Run OnInstanceDestroy on all NPCs in the instance
-		for (const auto &it : idata->map) {
-			struct map_data *mapdata = map_getmapdata(it.m);
+	// Run OnInstanceDestroy on all NPCs in the instance, pre-built instances never ran OnInstanceInit
+	for (const auto &it : idata->map) {
+		struct map_data *mapdata = map_getmapdata(it.m);
 
+		if (idata->state == INSTANCE_BUSY)
 			map_foreachinallarea(instance_npcdestroy, it.m, 0, 0, mapdata->xs, mapdata->ys, BL_NPC, it.m);
-			map_delinstancemap(it.m);
-		}
+		map_delinstancemap(it.m);
 	}
 
 	if(idata->keep_timer != INVALID_TIMER) {
@@ -1039,8 +1178,11 @@ void do_reload_instance(void)
 		if (!idata || idata->map.empty())
 			continue;
 		else {
-			// First we load the NPCs again
-			instance_addnpc(idata);
+			// First we load the NPCs again, pre-built instances run OnInstanceInit once handed out
+			if (idata->state == INSTANCE_BUSY)
+				instance_addnpc(idata);
+			else
+				instance_duplicatenpc(idata);
 
 			// Create new keep timer
 			std::shared_ptr<s_instance_db> db = instance_db.find(idata->id);
@@ -1112,12 +1254,17 @@ void do_init_instance(void) {
 
 	add_timer_func_list(instance_delete_timer,"instance_delete_timer");
 	add_timer_func_list(instance_subscription_timer,"instance_subscription_timer");
+	add_timer_func_list(instance_pool_timer,"instance_pool_timer");
+	add_timer_interval(gettick() + INSTANCE_POOL_INTERVAL, instance_pool_timer, 0, 0, INSTANCE_POOL_INTERVAL, TIMER_PRIORITY_BACKGROUND);
 }
 
 /**
  * Finalizes the instances and instance database
  */
 void do_final_instance(void) {
-	for (const auto &it : instances)
-		instance_destroy(it.first);
+	// instance_destroy removes the entry
+	while (!instances.empty())
+		instance_destroy(instances.begin()->first);
+	instance_pool.clear();
+	instance_pool_retry.clear();
 }
@@ -26,7 +26,8 @@ extern int instance_count;
 
 enum e_instance_state : uint8 {
 	INSTANCE_IDLE,
-	INSTANCE_BUSY
+	INSTANCE_BUSY,
+	INSTANCE_POOL ///< Built ahead of time, waiting to be handed out by instance_create
 };
 
 enum e_instance_mode : uint8 {
@@ -92,6 +93,7 @@ struct s_instance_db {
 	//bool destroyable; ///< Destroyable flag
 	struct point enter; ///< Instance entry point
 	std::vector<int16> maplist; ///< Maps in instance
+	uint16 pool_size; ///< Amount of instances built ahead of time
 };
 
 class InstanceDatabase : public TypesafeYamlDatabase<int32, s_instance_db> {
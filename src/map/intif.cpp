@@ -3388,6 +3388,47 @@ void intif_parse_itembound_store2gstorage(int fd) {
 }
 #endif
 
+/**
+ * Items of a player's storage as the char-server has them, last sent or received
+ * @param sd: Player data
+ * @param stor: Storage data
+ * @param size: Size of the items in bytes
+ * @return Base of the storage or NULL for storages without base
+ */
+static struct item **intif_storage_base(struct map_session_data *sd, struct s_storage *stor, size_t *size)
+{
+	switch (stor->type) {
+		case TABLE_INVENTORY:
+			*size = MAX_INVENTORY * sizeof(struct item);
+			return &sd->inventory_base;
+		case TABLE_CART:
+			*size = MAX_CART * sizeof(struct item);
+			return &sd->cart_base;
+		case TABLE_STORAGE:
+			*size = MAX_STORAGE * sizeof(struct item);
+			return (stor == &sd->premiumStorage) ? &sd->premium_storage_base : &sd->storage_base;
+		default:
+			return NULL;
+	}
+}
+
+/**
+ * Remembers the items of a player's storage as the char-server has them
+ * @param sd: Player data
+ * @param stor: Storage data
+ */
+static void intif_storage_setbase(struct map_session_data *sd, struct s_storage *stor)
+{
+	size_t size;
+	struct item **base = intif_storage_base(sd, stor, &size);
+
+	if (base == NULL)
+		return;
+	if (*base == NULL)
+		*base = (struct item *)aMalloc(size);
+	memcpy(*base, stor->u.items_inventory, size);
+}
+
 /**
  * Receive inventory/cart/storage data for player
  * IZ 0x388a <size>.W <type>.B <account_id>.L <result>.B <storage>.?B
@@ -3447,6 +3488,7 @@ static bool intif_parse_StorageReceived(int fd)
 	}
 
 	memcpy(stor, p, sz_stor); //copy the items data to correct destination
+	intif_storage_setbase(sd, stor);
 
 	switch (type) {
 		case TABLE_INVENTORY: {
@@ -3532,8 +3574,27 @@ static void intif_parse_StorageSaved(int fd)
 			default:
 				break;
 		}
-	} else
+	} else {
+		struct map_session_data *sd = map_id2sd(RFIFOL(fd, 2));
+
 		ShowError("Failed to save inventory/cart/storage data (AID: %d, type: %d).\n", RFIFOL(fd, 2), RFIFOB(fd, 7));
+
+		// The char-server doesn't have the items of the base, the next save has to be sent
+		if (sd) {
+			struct item **base = NULL;
+
+			switch (RFIFOB(fd, 7)) {
+				case TABLE_INVENTORY: base = &sd->inventory_base; break;
+				case TABLE_CART: base = &sd->cart_base; break;
+				case TABLE_STORAGE: base = RFIFOB(fd, 8) ? &sd->premium_storage_base : &sd->storage_base; break;
+				default: break;
+			}
+			if (base && *base) {
+				aFree(*base);
+				*base = NULL;
+			}
+		}
+	}
 }
 
 /**
@@ -3585,6 +3646,7 @@ bool intif_storage_request(struct map_session_data *sd, enum storage_type type,
 
 /**
  * Request to save inventory/cart/storage data from player
+ * Only the slots used by the storage type are sent, the char-server clears the rest.
  * ZI 0x308b <size>.W <type>.B <account_id>.L <char_id>.L <entries>.?B
  * @param sd: Player data
  * @param stor: Storage data
@@ -3597,6 +3659,12 @@ bool intif_storage_save(struct map_session_data *sd, struct s_storage *stor)
 	nullpo_retr(false, sd);
 	nullpo_retr(false, stor);
 
+	switch (stor->type) {
+		case TABLE_INVENTORY: stor_size = offsetof(struct s_storage, u) + MAX_INVENTORY * sizeof(struct item); break;
+		case TABLE_CART: stor_size = offsetof(struct s_storage, u) + MAX_CART * sizeof(struct item); break;
+		default: break;
+	}
+
 	if (CheckForCharServer())
 		return false;
 
@@ -3608,9 +3676,40 @@ bool intif_storage_save(struct map_session_data *sd, struct s_storage *stor)
 	WFIFOL(inter_fd, 9) = sd->status.char_id;
 	memcpy(WFIFOP(inter_fd, 13), stor, stor_size);
 	WFIFOSET(inter_fd, stor_size+13);
+	intif_storage_setbase(sd, stor);
 	return true;
 }
 
+/**
+ * Checks if a player's storage changed since it was last sent to or received from the char-server
+ * @param sd: Player data
+ * @param stor: Storage data
+ * @return true if the storage has to be saved
+ */
+bool intif_storage_changed(struct map_session_data *sd, struct s_storage *stor)
+{
+	size_t size;
+	struct item **base = intif_storage_base(sd, stor, &size);
+
+	return base == NULL || *base == NULL || memcmp(*base, stor->u.items_inventory, size) != 0;
+}
+
+/**
+ * Frees the storage bases of a player, the next saves are sent in any case
+ * @param sd: Player data
+ */
+void intif_storage_freebase(struct map_session_data *sd)
+{
+	struct item **bases[] = { &sd->inventory_base, &sd->cart_base, &sd->storage_base, &sd->premium_storage_base };
+
+	for (struct item **base : bases) {
+		if (*base) {
+			aFree(*base);
+			*base = NULL;
+		}
+	}
+}
+
 int intif_clan_requestclans(){
 	if (CheckForCharServer())
 		return 0;
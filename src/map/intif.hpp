@@ -126,6 +126,8 @@ int intif_request_accinfo(int u_fd, int aid, int group_lv, char* query, char typ
 // STORAGE
 bool intif_storage_request(struct map_session_data *sd, enum storage_type type, uint8 stor_id, uint8 mode);
 bool intif_storage_save(struct map_session_data *sd, struct s_storage *stor);
+bool intif_storage_changed(struct map_session_data *sd, struct s_storage *stor);
+void intif_storage_freebase(struct map_session_data *sd);
 
 int CheckForCharServer(void);
 
@@ -3,7 +3,12 @@
 
 #include "itemdb.hpp"
 
+#include <algorithm>
 #include <stdlib.h>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "../common/malloc.hpp"
 #include "../common/nullpo.hpp"
@@ -26,6 +31,15 @@ static DBMap *itemdb_combo; /// Item Combo DB
 static DBMap *itemdb_group; /// Item Group DB
 static DBMap *itemdb_randomopt; /// Random option DB
 static DBMap *itemdb_randomopt_group; /// Random option group DB
+static struct item_data *itemdb_array[MAX_ITEMID + 1]; /// Item DB indexed by item ID, mirrors itemdb for fast lookups
+
+/// Item name lookup indexes, keyed by lowercase name
+static struct s_itemdb_name_index {
+	std::unordered_map<std::string, std::vector<struct item_data*>> aegis; /// Aegis name -> items
+	std::unordered_map<std::string, std::vector<struct item_data*>> display; /// Client displayed name -> items
+	std::unordered_map<uint32, std::vector<struct item_data*>> trigram; /// Trigram of either name -> items, built on the first partial search
+	bool trigram_dirty; /// Whether trigram has to be rebuilt
+} itemdb_names;
 
 struct item_data *dummy_item; /// This is the default dummy item used for non-existant items. [Skotlex]
 
@@ -97,44 +111,120 @@ int16 itemdb_group_item_exists_pc(struct map_session_data *sd, unsigned short gr
 }
 
 /**
- * Search for item name
- * name = item alias, so we should find items aliases first. if not found then look for "jname" (full name)
+ * Returns the lowercase version of a name, used as key of the name indexes
+ * @param str: Name
+ * @return Lowercase name
+ */
+static std::string itemdb_name_fold(const char *str)
+{
+	std::string folded(str);
+
+	for (auto &c : folded)
+		c = TOLOWER(c);
+
+	return folded;
+}
+
+/**
+ * Adds or removes an item from the exact name indexes, call before and after changing its names
+ * @param id: Item data
+ * @param add: True to add, false to remove
+ */
+static void itemdb_name_index(struct item_data *id, bool add)
+{
+	std::unordered_map<std::string, std::vector<struct item_data*>> *indexes[] = { &itemdb_names.aegis, &itemdb_names.display };
+	const char *names[] = { id->name, id->jname };
+
+	for (int i = 0; i < ARRAYLENGTH(indexes); i++) {
+		if (!names[i][0])
+			continue;
+
+		std::string key = itemdb_name_fold(names[i]);
+
+		if (add) {
+			(*indexes[i])[key].push_back(id);
+			continue;
+		}
+
+		auto it = indexes[i]->find(key);
+
+		if (it == indexes[i]->end())
+			continue;
+
+		it->second.erase(std::remove(it->second.begin(), it->second.end(), id), it->second.end());
+		if (it->second.empty())
+			indexes[i]->erase(it);
+	}
+
+	itemdb_names.trigram_dirty = true;
+}
+
+/**
+ * Empties all name indexes, call before the item data is freed
+ */
+static void itemdb_name_index_clear(void)
+{
+	itemdb_names.aegis.clear();
+	itemdb_names.display.clear();
+	itemdb_names.trigram.clear();
+	itemdb_names.trigram_dirty = true;
+}
+
+/**
+ * Packs 3 lowercase characters into a trigram key
+ */
+static inline uint32 itemdb_trigram(const char *str)
+{
+	return ((uint32)(uint8)str[0] << 16) | ((uint32)(uint8)str[1] << 8) | (uint32)(uint8)str[2];
+}
+
+/**
  * @see DBApply
  */
-static int itemdb_searchname_sub(DBKey key, DBData *data, va_list ap)
+static int itemdb_name_trigram_sub(DBKey key, DBData *data, va_list ap)
 {
-	struct item_data *item = (struct item_data *)db_data2ptr(data), **dst, **dst2;
-	char *str;
-	str = va_arg(ap,char *);
-	dst = va_arg(ap,struct item_data **);
-	dst2 = va_arg(ap,struct item_data **);
-
-	//Absolute priority to Aegis code name.
-	if (dst != NULL && strcmpi(item->name, str) == 0)
-		*dst = item;
-
-	//Second priority to Client displayed name.
-	if (dst2 != NULL && strcmpi(item->jname, str) == 0)
-		*dst2 = item;
+	struct item_data *id = (struct item_data *)db_data2ptr(data);
+	std::unordered_set<uint32> *trigrams = va_arg(ap, std::unordered_set<uint32> *);
+
+	trigrams->clear();
+
+	for (const char *name : { id->name, id->jname }) {
+		std::string folded = itemdb_name_fold(name);
+
+		for (size_t i = 0; i + 3 <= folded.length(); i++)
+			trigrams->insert(itemdb_trigram(&folded[i]));
+	}
+
+	for (uint32 trigram : *trigrams)
+		itemdb_names.trigram[trigram].push_back(id);
+
 	return 0;
 }
 
 /*==========================================
  * Return item data from item name. (lookup)
+ * Aegis names have priority over client displayed names.
  * @param str Item Name
  * @param aegis_only
  * @return item data
  *------------------------------------------*/
 static struct item_data* itemdb_searchname1(const char *str, bool aegis_only)
 {
-	struct item_data *item = NULL, * item2 = NULL;
+	std::string key = itemdb_name_fold(str);
+	auto it = itemdb_names.aegis.find(key);
 
-	if( !aegis_only )
-		itemdb->foreach(itemdb, itemdb_searchname_sub, str, &item, &item2);
-	else
-		itemdb->foreach(itemdb, itemdb_searchname_sub, str, &item, NULL);
+	if (it != itemdb_names.aegis.end())
+		return it->second.back();
+
+	if (aegis_only)
+		return NULL;
+
+	it = itemdb_names.display.find(key);
 
-	return ((item) ? item : item2);
+	if (it != itemdb_names.display.end())
+		return it->second.back();
+
+	return NULL;
 }
 
 struct item_data* itemdb_searchname(const char *str)
@@ -170,12 +260,46 @@ static int itemdb_searchname_array_sub(DBKey key, DBData data, va_list ap)
  *------------------------------------------*/
 int itemdb_searchname_array(struct item_data** data, int size, const char *str)
 {
-	DBData *db_data[MAX_SEARCH];
-	int i, count = 0, db_count;
+	int count = 0;
+	std::string key = itemdb_name_fold(str);
+
+	if (key.length() < 3) { // too short for the trigram index
+		DBData *db_data[MAX_SEARCH];
+		int i, db_count;
 
-	db_count = itemdb->getall(itemdb, (DBData**)&db_data, size, itemdb_searchname_array_sub, str);
-	for (i = 0; i < db_count && count < size; i++)
-		data[count++] = (struct item_data*)db_data2ptr(db_data[i]);
+		db_count = itemdb->getall(itemdb, (DBData**)&db_data, size, itemdb_searchname_array_sub, str);
+		for (i = 0; i < db_count && count < size; i++)
+			data[count++] = (struct item_data*)db_data2ptr(db_data[i]);
+
+		return count;
+	}
+
+	if (itemdb_names.trigram_dirty) {
+		std::unordered_set<uint32> trigrams;
+
+		itemdb_names.trigram.clear();
+		itemdb->foreach(itemdb, itemdb_name_trigram_sub, &trigrams);
+		itemdb_names.trigram_dirty = false;
+	}
+
+	// Only the items sharing the rarest trigram of the search can match
+	std::vector<struct item_data*> *candidates = nullptr;
+
+	for (size_t i = 0; i + 3 <= key.length(); i++) {
+		auto it = itemdb_names.trigram.find(itemdb_trigram(&key[i]));
+
+		if (it == itemdb_names.trigram.end())
+			return 0;
+		if (candidates == nullptr || it->second.size() < candidates->size())
+			candidates = &it->second;
+	}
+
+	for (struct item_data *id : *candidates) {
+		if (count >= size)
+			break;
+		if (stristr(id->jname, str) || stristr(id->name, str))
+			data[count++] = id;
+	}
 
 	return count;
 }
@@ -312,7 +436,7 @@ char itemdb_pc_get_itemgroup(uint16 group_id, bool identify, struct map_session_
 * @return *item_data if item is exist, or NULL if not
 */
 struct item_data* itemdb_exists(unsigned short nameid) {
-	return ((struct item_data*)uidb_get(itemdb,nameid));
+	return itemdb_array[nameid];
 }
 
 /// Returns name type of ammunition [Cydh]
@@ -460,6 +584,7 @@ static struct item_data *itemdb_create_item(unsigned short nameid) {
 	id->nameid = nameid;
 	id->type = IT_ETC; //Etc item
 	uidb_put(itemdb, nameid, id);
+	itemdb_array[nameid] = id;
 	return id;
 }
 
@@ -472,7 +597,7 @@ struct item_data* itemdb_search(unsigned short nameid) {
 	struct item_data* id = NULL;
 	if (nameid == dummy_item->nameid)
 		id = dummy_item;
-	else if (!(id = (struct item_data*)uidb_get(itemdb, nameid))) {
+	else if (!(id = itemdb_array[nameid])) {
 		ShowWarning("itemdb_search: Item ID %hu does not exists in the item_db. Using dummy data.\n", nameid);
 		id = dummy_item;
 	}
@@ -1349,10 +1474,12 @@ static bool itemdb_parse_dbrow(char** str, const char* source, int line, int scr
 
 		// Adds a new Item ID
 		id = itemdb_create_item(nameid);
-	}
+	} else
+		itemdb_name_index(id, false);
 
 	safestrncpy(id->name, str[1], sizeof(id->name));
 	safestrncpy(id->jname, str[2], sizeof(id->jname));
+	itemdb_name_index(id, true);
 
 	id->type = atoi(str[3]);
 
@@ -1457,6 +1584,7 @@ static bool itemdb_parse_dbrow(char** str, const char* source, int line, int scr
 	if (!id->nameid) {
 		id->nameid = nameid;
 		uidb_put(itemdb, nameid, id);
+		itemdb_array[nameid] = id;
 	}
 	return true;
 }
@@ -2033,6 +2161,8 @@ void itemdb_reload(void) {
 	itemdb_group->clear(itemdb_group, itemdb_group_free);
 	itemdb_randomopt->clear(itemdb_randomopt, itemdb_randomopt_free);
 	itemdb_randomopt_group->clear(itemdb_randomopt_group, itemdb_randomopt_group_free);
+	itemdb_name_index_clear();
+	memset(itemdb_array, 0, sizeof(itemdb_array));
 	itemdb->clear(itemdb, itemdb_final_sub);
 	db_clear(itemdb_combo);
 	memset(item_vend, 0, sizeof(item_vend)); // Extended Vending system [Lilith]
@@ -2064,6 +2194,10 @@ void itemdb_reload(void) {
 		}
 
 		pc_setinventorydata(sd);
+		if (sd->inventorylist_cache) { // item data may be reallocated at the same address
+			aFree(sd->inventorylist_cache);
+			sd->inventorylist_cache = nullptr;
+		}
 		pc_check_available_item(sd, ITMCHK_ALL); // Check for invalid(ated) items.
 		pc_load_combo(sd); // Check to see if new combos are available
 		status_calc_pc(sd, SCO_FORCE); // 
@@ -2079,6 +2213,8 @@ void do_final_itemdb(void) {
 	itemdb_group->destroy(itemdb_group, itemdb_group_free);
 	itemdb_randomopt->destroy(itemdb_randomopt, itemdb_randomopt_free);
 	itemdb_randomopt_group->destroy(itemdb_randomopt_group, itemdb_randomopt_group_free);
+	itemdb_name_index_clear();
+	memset(itemdb_array, 0, sizeof(itemdb_array));
 	itemdb->destroy(itemdb, itemdb_final_sub);
 	destroy_item_data(dummy_item);
 	if (battle_config.feature_roulette)
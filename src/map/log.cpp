@@ -3,13 +3,23 @@
 
 #include "log.hpp"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <stdarg.h>
 #include <stdlib.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "../common/cbasetypes.hpp"
 #include "../common/nullpo.hpp"
 #include "../common/showmsg.hpp"
 #include "../common/sql.hpp" // SQL_INNODB
 #include "../common/strlib.hpp"
+#include "../common/timer.hpp"
 
 #include "battle.hpp"
 #include "homunculus.hpp"
@@ -163,40 +173,404 @@ static bool should_log_item(unsigned short nameid, int amount, int refine)
 }
 
 
-/// logs items, that summon monsters
-void log_branch(struct map_session_data* sd)
+/// Milliseconds the log writer waits for more entries before writing a batch
+#define LOG_ASYNC_INTERVAL 100
+/// Length at which a multi-row INSERT is sent before the batch is complete
+#define LOG_STATEMENT_MAX (512 * 1024)
+/// Errors of the log writer kept until the map-server reports them
+#define LOG_ASYNC_MAX_ERRORS 16
+
+/// Entry of the asynchronous log queue
+struct s_log_entry {
+	bool sql;
+	uint32 rows;        ///< rows in data, for SQL logs
+	std::string target; ///< statement up to VALUES for SQL logs, file name otherwise
+	std::string data;   ///< rows of values for SQL logs, line otherwise
+};
+
+/// Multi-row INSERT built by the log writer
+struct s_log_statement {
+	std::string query;
+	uint32 rows;
+};
+
+/// Asynchronous log writer.
+/// The map-server thread is the only producer and the writer thread the only consumer of the ring,
+/// so the slots are handed over by the head and tail indexes alone, without a lock.
+static struct s_log_async {
+	std::vector<s_log_entry> ring;
+	std::atomic<size_t> head; ///< next slot written by the map-server
+	std::atomic<size_t> tail; ///< next slot read by the writer
+	std::atomic<bool> running;
+	std::thread* writer; ///< pointer, a joinable std::thread destroyed by exit() would terminate the process
+	std::mutex mutex;
+	std::condition_variable wakeup;
+	// errors of the writer, reported by the map-server since showmsg is not thread safe
+	std::mutex error_mutex;
+	std::vector<std::string> errors;
+	uint32 errors_lost;
+	std::atomic<bool> has_errors;
+	// only used by the map-server
+	uint64 queued;
+	uint64 dropped;
+	t_tick drop_report;
+} log_async;
+
+/// Rows of a log table collected on the map-server thread, sent as one multi-row INSERT
+/// once log_batch_rows rows are collected, by log_batch_timer or on shutdown.
+struct s_log_batch {
+	std::string head; ///< statement up to VALUES
+	std::string rows;
+	uint32 count;
+};
+
+static s_log_batch log_batch_pick, log_batch_zeny;
+
+
+/// formats a log entry
+static std::string log_format(const char* fmt, ...)
 {
-	nullpo_retv(sd);
+	std::string str;
+	va_list ap;
+	int len;
 
-	if( !log_config.branch )
+	va_start(ap, fmt);
+	len = vsnprintf(NULL, 0, fmt, ap);
+	va_end(ap);
+
+	if( len <= 0 )
+		return str;
+
+	str.resize(len);
+	va_start(ap, fmt);
+	vsnprintf(&str[0], len + 1, fmt, ap);
+	va_end(ap);
+
+	return str;
+}
+
+
+/// time value of a log row
+/// Rows written later by the log writer or collected in a batch get the current time as quoted DATETIME,
+/// NOW() would be the time of the write and not of the event. Rows written right away keep the database's NOW().
+/// @param batched : row is collected in a batch
+static const char* log_sql_now(bool batched = false)
+{
+	static char timestring[24];
+	static time_t last = 0;
+	time_t curtime;
+
+	if( !batched && !log_async.running.load(std::memory_order_relaxed) )
+		return "NOW()";
+
+	curtime = time(NULL);
+
+	if( curtime != last )
+	{
+		strftime(timestring, sizeof(timestring), "'%Y-%m-%d %H:%M:%S'", localtime(&curtime));
+		last = curtime;
+	}
+	return timestring;
+}
+
+
+/// escapes a string for a log query, the result is not quoted
+static std::string log_escape(const char* str, size_t max_len)
+{
+	size_t len = safestrnlen(str, max_len);
+	std::string escaped(len * 2 + 1, '\0');
+
+	escaped.resize(Sql_EscapeStringLen(logmysql_handle, &escaped[0], str, len));
+	return escaped;
+}
+
+
+/// queues an error of the log writer for the map-server to report
+static void log_async_error(const char* fmt, ...)
+{
+	char message[512];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(message, sizeof(message), fmt, ap);
+	va_end(ap);
+
+	std::lock_guard<std::mutex> lock(log_async.error_mutex);
+
+	if( log_async.errors.size() < LOG_ASYNC_MAX_ERRORS )
+		log_async.errors.push_back(message);
+	else
+		log_async.errors_lost++;
+	log_async.has_errors = true;
+}
+
+
+/// reports the errors of the log writer
+static void log_async_report_errors(void)
+{
+	std::vector<std::string> errors;
+	uint32 lost;
+
+	if( !log_async.has_errors.exchange(false) )
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(log_async.error_mutex);
+
+		errors.swap(log_async.errors);
+		lost = log_async.errors_lost;
+		log_async.errors_lost = 0;
+	}
+
+	for( const auto& error : errors )
+		ShowSQL("Log writer: %s\n", error.c_str());
+	if( lost )
+		ShowSQL("Log writer: %u more errors were not shown.\n", lost);
+}
+
+
+/// sends a multi-row INSERT of the log writer, connecting to the log database if needed
+static void log_async_flush_sql(SqlThread*& sql, s_log_statement& statement)
+{
+	char error[256];
+
+	if( statement.rows == 0 )
+		return;
+
+	if( sql == NULL && ( sql = SqlThread_Connect(log_db_id, log_db_pw, log_db_ip, log_db_port, log_db_db, default_codepage, error, sizeof(error)) ) == NULL )
+		log_async_error("Lost %u rows, can't connect to the log database: %s", statement.rows, error);
+	else if( SQL_ERROR == SqlThread_QueryStr(sql, statement.query.c_str(), statement.query.length(), error, sizeof(error)) )
+		log_async_error("Lost %u rows: %s", statement.rows, error);
+
+	statement.query.clear();
+	statement.rows = 0;
+}
+
+
+/// appends the lines collected by the log writer to a log file
+static void log_async_flush_file(const std::string& file, std::string& lines)
+{
+	FILE* logfp;
+
+	if( lines.empty() )
 		return;
 
-	if( log_config.sql_logs ) {
-		SqlStmt* stmt;
-		stmt = SqlStmt_Malloc(logmysql_handle);
-		if( SQL_SUCCESS != SqlStmt_Prepare(stmt, LOG_QUERY " INTO `%s` (`branch_date`, `account_id`, `char_id`, `char_name`, `map`) VALUES (NOW(), '%d', '%d', ?, '%s')", log_config.log_branch, sd->status.account_id, sd->status.char_id, mapindex_id2name(sd->mapindex) )
-		||  SQL_SUCCESS != SqlStmt_BindParam(stmt, 0, SQLDT_STRING, sd->status.name, strnlen(sd->status.name, NAME_LENGTH))
-		||  SQL_SUCCESS != SqlStmt_Execute(stmt) )
+	if( ( logfp = fopen(file.c_str(), "a") ) == NULL )
+		log_async_error("Lost log lines, can't open '%s'.", file.c_str());
+	else
+	{
+		fwrite(lines.data(), 1, lines.length(), logfp);
+		fclose(logfp);
+	}
+
+	lines.clear();
+}
+
+
+/// log writer thread, writes the queued entries in batches
+/// Rows for the same table become one multi-row INSERT and every file is opened once per batch.
+static void log_async_writer(void)
+{
+	SqlThread* sql = NULL;
+	std::unordered_map<std::string, s_log_statement> statements; // statement head -> multi-row INSERT
+	std::unordered_map<std::string, std::string> files; // file name -> lines
+	size_t size = log_async.ring.size();
+
+	for(;;)
+	{
+		// read the flag first, entries queued before the shutdown are still written
+		bool running = log_async.running.load();
+		size_t tail = log_async.tail.load(std::memory_order_relaxed);
+		size_t head = log_async.head.load(std::memory_order_acquire);
+
+		for( ; tail != head; tail++ )
 		{
-			SqlStmt_ShowDebug(stmt);
-			SqlStmt_Free(stmt);
-			return;
+			s_log_entry& entry = log_async.ring[tail % size];
+
+			if( entry.sql )
+			{
+				s_log_statement& statement = statements[entry.target];
+
+				if( statement.rows == 0 )
+					statement.query = entry.target;
+				else
+					statement.query += ',';
+				statement.query += entry.data;
+				statement.rows += entry.rows;
+
+				if( statement.query.length() >= LOG_STATEMENT_MAX )
+					log_async_flush_sql(sql, statement);
+			}
+			else
+				files[entry.target] += entry.data;
+
+			// hand the slot back as soon as possible, the map-server may be waiting for it
+			log_async.tail.store(tail + 1, std::memory_order_release);
 		}
-		SqlStmt_Free(stmt);
+
+		for( auto& it : statements )
+			log_async_flush_sql(sql, it.second);
+		for( auto& it : files )
+			log_async_flush_file(it.first, it.second);
+
+		if( !running )
+			break;
+
+		std::unique_lock<std::mutex> lock(log_async.mutex);
+		log_async.wakeup.wait_for(lock, std::chrono::milliseconds(LOG_ASYNC_INTERVAL));
 	}
-	else
+
+	SqlThread_Free(sql);
+}
+
+
+/// queues an entry for the log writer
+/// When the queue is full the entry is dropped or the map-server waits for the writer, according to log_async_overflow.
+static void log_async_push(bool sql, const std::string& target, const std::string& data, uint32 rows)
+{
+	size_t size = log_async.ring.size();
+	size_t head = log_async.head.load(std::memory_order_relaxed);
+	size_t used;
+
+	log_async_report_errors();
+
+	while( ( used = head - log_async.tail.load(std::memory_order_acquire) ) >= size )
 	{
-		char timestring[255];
-		time_t curtime;
-		FILE* logfp;
+		if( log_config.async_overflow == LOG_OVERFLOW_DROP )
+		{
+			t_tick tick = gettick();
 
-		if( ( logfp = fopen(log_config.log_branch, "a") ) == NULL )
+			if( log_async.dropped++ == 0 || DIFF_TICK(tick, log_async.drop_report) >= 60000 )
+			{
+				ShowWarning("log_async_push: Log queue is full, %" PRIu64 " entries dropped so far (see log_async_queue in conf/log_athena.conf).\n", log_async.dropped);
+				log_async.drop_report = tick;
+			}
 			return;
-		time(&curtime);
-		strftime(timestring, sizeof(timestring), log_timestamp_format, localtime(&curtime));
-		fprintf(logfp,"%s - %s[%d:%d]\t%s\n", timestring, sd->status.name, sd->status.account_id, sd->status.char_id, mapindex_id2name(sd->mapindex));
-		fclose(logfp);
+		}
+
+		// LOG_OVERFLOW_BLOCK
+		log_async.wakeup.notify_one();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	// assigning keeps the capacity of the slot's strings, a warm queue doesn't allocate
+	s_log_entry& entry = log_async.ring[head % size];
+
+	entry.sql = sql;
+	entry.rows = rows;
+	entry.target = target;
+	entry.data = data;
+	log_async.head.store(head + 1, std::memory_order_release);
+	log_async.queued++;
+
+	// the writer wakes up every LOG_ASYNC_INTERVAL ms, wake it early when the queue fills up
+	if( used + 1 >= size / 2 )
+		log_async.wakeup.notify_one();
+}
+
+
+/// sends rows to a log table
+/// @param head : statement up to VALUES
+/// @param rows : rows of values in parentheses, separated by commas
+/// @param count : number of rows
+static void log_send_sql(const std::string& head, const std::string& rows, uint32 count)
+{
+	if( log_async.running.load(std::memory_order_relaxed) )
+	{
+		log_async_push(true, head, rows, count);
+		return;
+	}
+
+	if( SQL_ERROR == Sql_QueryStr(logmysql_handle, (head + rows).c_str()) )
+		Sql_ShowDebug(logmysql_handle);
+}
+
+
+/// sends the rows collected in a batch as one multi-row INSERT
+static void log_batch_flush(s_log_batch& batch)
+{
+	if( batch.count == 0 )
+		return;
+
+	log_send_sql(batch.head, batch.rows, batch.count);
+	batch.rows.clear();
+	batch.count = 0;
+}
+
+
+/// sends the collected rows of all batches every log_batch_interval ms
+static TIMER_FUNC(log_batch_timer)
+{
+	log_batch_flush(log_batch_pick);
+	log_batch_flush(log_batch_zeny);
+	return 0;
+}
+
+
+/// writes a row to a log table
+/// @param table : log table
+/// @param columns : columns of the row
+/// @param values : values of the row, strings escaped and quoted
+/// @param batch : batch collecting the rows of the table, NULL to send the row right away
+static void log_write_sql(const char* table, const char* columns, const std::string& values, s_log_batch* batch = NULL)
+{
+	if( batch == NULL || log_config.batch_rows <= 1 )
+	{
+		log_send_sql(log_format(LOG_QUERY " INTO `%s` (%s) VALUES ", table, columns), "(" + values + ")", 1);
+		return;
+	}
+
+	if( batch->count++ == 0 )
+		batch->head = log_format(LOG_QUERY " INTO `%s` (%s) VALUES ", table, columns);
+	else
+		batch->rows += ',';
+	batch->rows += '(';
+	batch->rows += values;
+	batch->rows += ')';
+
+	if( batch->count >= (uint32)log_config.batch_rows || batch->rows.length() >= LOG_STATEMENT_MAX )
+		log_batch_flush(*batch);
+}
+
+
+/// writes a line to a log file, prefixed with the current time
+static void log_write_file(const char* file, const std::string& line)
+{
+	char timestring[255];
+	time_t curtime;
+	FILE* logfp;
+
+	time(&curtime);
+	strftime(timestring, sizeof(timestring), log_timestamp_format, localtime(&curtime));
+
+	std::string entry = log_format("%s - ", timestring) + line;
+
+	if( log_async.running.load(std::memory_order_relaxed) )
+	{
+		log_async_push(false, file, entry, 1);
+		return;
 	}
+
+	if( ( logfp = fopen(file, "a") ) == NULL )
+		return;
+	fputs(entry.c_str(), logfp);
+	fclose(logfp);
+}
+
+
+/// logs items, that summon monsters
+void log_branch(struct map_session_data* sd)
+{
+	nullpo_retv(sd);
+
+	if( !log_config.branch )
+		return;
+
+	if( log_config.sql_logs )
+		log_write_sql(log_config.log_branch, "`branch_date`, `account_id`, `char_id`, `char_name`, `map`",
+			log_format("%s, '%d', '%d', '%s', '%s'", log_sql_now(), sd->status.account_id, sd->status.char_id, log_escape(sd->status.name, NAME_LENGTH).c_str(), mapindex_id2name(sd->mapindex)));
+	else
+		log_write_file(log_config.log_branch, log_format("%s[%d:%d]\t%s\n", sd->status.name, sd->status.account_id, sd->status.char_id, mapindex_id2name(sd->mapindex)));
 }
 
 /// logs item transactions (generic)
@@ -213,47 +587,30 @@ void log_pick(int id, int16 m, e_log_pick_type type, int amount, struct item* it
 
 	if( log_config.sql_logs )
 	{
+		static std::string columns;
+		std::string values;
 		int i;
-		SqlStmt* stmt = SqlStmt_Malloc(logmysql_handle);
-		StringBuf buf;
-		StringBuf_Init(&buf);
-
-		StringBuf_Printf(&buf, "%s INTO `%s` (`time`, `char_id`, `type`, `nameid`, `amount`, `refine`, `map`, `unique_id`, `bound`", LOG_QUERY, log_config.log_pick);
-		for (i = 0; i < MAX_SLOTS; ++i)
-			StringBuf_Printf(&buf, ", `card%d`", i);
-		for (i = 0; i < MAX_ITEM_RDM_OPT; ++i) {
-			StringBuf_Printf(&buf, ", `option_id%d`", i);
-			StringBuf_Printf(&buf, ", `option_val%d`", i);
-			StringBuf_Printf(&buf, ", `option_parm%d`", i);
+
+		if( columns.empty() )
+		{
+			columns = "`time`, `char_id`, `type`, `nameid`, `amount`, `refine`, `map`, `unique_id`, `bound`";
+			for (i = 0; i < MAX_SLOTS; ++i)
+				columns += log_format(", `card%d`", i);
+			for (i = 0; i < MAX_ITEM_RDM_OPT; ++i)
+				columns += log_format(", `option_id%d`, `option_val%d`, `option_parm%d`", i, i, i);
 		}
-		StringBuf_Printf(&buf, ") VALUES(NOW(),'%u','%c','%d','%d','%d','%s','%" PRIu64 "','%d'",
-			id, log_picktype2char(type), itm->nameid, amount, itm->refine, map_getmapdata(m)->name[0] ? map_getmapdata(m)->name : "", itm->unique_id, itm->bound);
 
+		values = log_format("%s,'%u','%c','%d','%d','%d','%s','%" PRIu64 "','%d'",
+			log_sql_now(log_config.batch_rows > 1), id, log_picktype2char(type), itm->nameid, amount, itm->refine, map_getmapdata(m)->name[0] ? map_getmapdata(m)->name : "", itm->unique_id, itm->bound);
 		for (i = 0; i < MAX_SLOTS; i++)
-			StringBuf_Printf(&buf, ",'%d'", itm->card[i]);
+			values += log_format(",'%d'", itm->card[i]);
 		for (i = 0; i < MAX_ITEM_RDM_OPT; i++)
-			StringBuf_Printf(&buf, ",'%d','%d','%d'", itm->option[i].id, itm->option[i].value, itm->option[i].param);
-		StringBuf_Printf(&buf, ")");
+			values += log_format(",'%d','%d','%d'", itm->option[i].id, itm->option[i].value, itm->option[i].param);
 
-		if (SQL_SUCCESS != SqlStmt_PrepareStr(stmt, StringBuf_Value(&buf)) || SQL_SUCCESS != SqlStmt_Execute(stmt))
-			SqlStmt_ShowDebug(stmt);
-
-		SqlStmt_Free(stmt);
-		StringBuf_Destroy(&buf);
+		log_write_sql(log_config.log_pick, columns.c_str(), values, &log_batch_pick);
 	}
 	else
-	{
-		char timestring[255];
-		time_t curtime;
-		FILE* logfp;
-
-		if( ( logfp = fopen(log_config.log_pick, "a") ) == NULL )
-			return;
-		time(&curtime);
-		strftime(timestring, sizeof(timestring), log_timestamp_format, localtime(&curtime));
-		fprintf(logfp,"%s - %d\t%c\t%hu,%d,%d,%hu,%hu,%hu,%hu,%s,'%" PRIu64 "',%d\n", timestring, id, log_picktype2char(type), itm->nameid, amount, itm->refine, itm->card[0], itm->card[1], itm->card[2], itm->card[3], map_getmapdata(m)->name[0]?map_getmapdata(m)->name:"", itm->unique_id, itm->bound);
-		fclose(logfp);
-	}
+		log_write_file(log_config.log_pick, log_format("%d\t%c\t%hu,%d,%d,%hu,%hu,%hu,%hu,%s,'%" PRIu64 "',%d\n", id, log_picktype2char(type), itm->nameid, amount, itm->refine, itm->card[0], itm->card[1], itm->card[2], itm->card[3], map_getmapdata(m)->name[0]?map_getmapdata(m)->name:"", itm->unique_id, itm->bound));
 }
 
 /// logs item transactions (players)
@@ -280,27 +637,10 @@ void log_zeny(struct map_session_data* sd, e_log_pick_type type, struct map_sess
 		return;
 
 	if( log_config.sql_logs )
-	{
-		if( SQL_ERROR == Sql_Query(logmysql_handle, LOG_QUERY " INTO `%s` (`time`, `char_id`, `src_id`, `type`, `amount`, `map`) VALUES (NOW(), '%d', '%d', '%c', '%d', '%s')",
-			log_config.log_zeny, sd->status.char_id, src_sd->status.char_id, log_picktype2char(type), amount, mapindex_id2name(sd->mapindex)) )
-		{
-			Sql_ShowDebug(logmysql_handle);
-			return;
-		}
-	}
+		log_write_sql(log_config.log_zeny, "`time`, `char_id`, `src_id`, `type`, `amount`, `map`",
+			log_format("%s, '%d', '%d', '%c', '%d', '%s'", log_sql_now(log_config.batch_rows > 1), sd->status.char_id, src_sd->status.char_id, log_picktype2char(type), amount, mapindex_id2name(sd->mapindex)), &log_batch_zeny);
 	else
-	{
-		char timestring[255];
-		time_t curtime;
-		FILE* logfp;
-
-		if( ( logfp = fopen(log_config.log_zeny, "a") ) == NULL )
-			return;
-		time(&curtime);
-		strftime(timestring, sizeof(timestring), log_timestamp_format, localtime(&curtime));
-		fprintf(logfp, "%s - %s[%d]\t%s[%d]\t%d\t\n", timestring, src_sd->status.name, src_sd->status.account_id, sd->status.name, sd->status.account_id, amount);
-		fclose(logfp);
-	}
+		log_write_file(log_config.log_zeny, log_format("%s[%d]\t%s[%d]\t%d\t\n", src_sd->status.name, src_sd->status.account_id, sd->status.name, sd->status.account_id, amount));
 }
 
 
@@ -313,27 +653,10 @@ void log_mvpdrop(struct map_session_data* sd, int monster_id, unsigned int* log_
 		return;
 
 	if( log_config.sql_logs )
-	{
-		if( SQL_ERROR == Sql_Query(logmysql_handle, LOG_QUERY " INTO `%s` (`mvp_date`, `kill_char_id`, `monster_id`, `prize`, `mvpexp`, `map`) VALUES (NOW(), '%d', '%d', '%hu', '%u', '%s') ",
-			log_config.log_mvpdrop, sd->status.char_id, monster_id, (unsigned short)log_mvp[0], log_mvp[1], mapindex_id2name(sd->mapindex)) )
-		{
-			Sql_ShowDebug(logmysql_handle);
-			return;
-		}
-	}
+		log_write_sql(log_config.log_mvpdrop, "`mvp_date`, `kill_char_id`, `monster_id`, `prize`, `mvpexp`, `map`",
+			log_format("%s, '%d', '%d', '%hu', '%u', '%s'", log_sql_now(), sd->status.char_id, monster_id, (unsigned short)log_mvp[0], log_mvp[1], mapindex_id2name(sd->mapindex)));
 	else
-	{
-		char timestring[255];
-		time_t curtime;
-		FILE* logfp;
-
-		if( ( logfp = fopen(log_config.log_mvpdrop,"a") ) == NULL )
-			return;
-		time(&curtime);
-		strftime(timestring, sizeof(timestring), log_timestamp_format, localtime(&curtime));
-		fprintf(logfp,"%s - %s[%d:%d]\t%d\t%hu,%u\n", timestring, sd->status.name, sd->status.account_id, sd->status.char_id, monster_id, (unsigned short)log_mvp[0], log_mvp[1]);
-		fclose(logfp);
-	}
+		log_write_file(log_config.log_mvpdrop, log_format("%s[%d:%d]\t%d\t%hu,%u\n", sd->status.name, sd->status.account_id, sd->status.char_id, monster_id, (unsigned short)log_mvp[0], log_mvp[1]));
 }
 
 
@@ -347,34 +670,10 @@ void log_atcommand(struct map_session_data* sd, const char* message)
 		return;
 
 	if( log_config.sql_logs )
-	{
-		SqlStmt* stmt;
-
-		stmt = SqlStmt_Malloc(logmysql_handle);
-		if( SQL_SUCCESS != SqlStmt_Prepare(stmt, LOG_QUERY " INTO `%s` (`atcommand_date`, `account_id`, `char_id`, `char_name`, `map`, `command`) VALUES (NOW(), '%d', '%d', ?, '%s', ?)", log_config.log_gm, sd->status.account_id, sd->status.char_id, mapindex_id2name(sd->mapindex) )
-		||  SQL_SUCCESS != SqlStmt_BindParam(stmt, 0, SQLDT_STRING, sd->status.name, strnlen(sd->status.name, NAME_LENGTH))
-		||  SQL_SUCCESS != SqlStmt_BindParam(stmt, 1, SQLDT_STRING, (char*)message, safestrnlen(message, 255))
-		||  SQL_SUCCESS != SqlStmt_Execute(stmt) )
-		{
-			SqlStmt_ShowDebug(stmt);
-			SqlStmt_Free(stmt);
-			return;
-		}
-		SqlStmt_Free(stmt);
-	}
+		log_write_sql(log_config.log_gm, "`atcommand_date`, `account_id`, `char_id`, `char_name`, `map`, `command`",
+			log_format("%s, '%d', '%d', '%s', '%s', '%s'", log_sql_now(), sd->status.account_id, sd->status.char_id, log_escape(sd->status.name, NAME_LENGTH).c_str(), mapindex_id2name(sd->mapindex), log_escape(message, 255).c_str()));
 	else
-	{
-		char timestring[255];
-		time_t curtime;
-		FILE* logfp;
-
-		if( ( logfp = fopen(log_config.log_gm, "a") ) == NULL )
-			return;
-		time(&curtime);
-		strftime(timestring, sizeof(timestring), log_timestamp_format, localtime(&curtime));
-		fprintf(logfp, "%s - %s[%d]: %s\n", timestring, sd->status.name, sd->status.account_id, message);
-		fclose(logfp);
-	}
+		log_write_file(log_config.log_gm, log_format("%s[%d]: %s\n", sd->status.name, sd->status.account_id, message));
 }
 
 /// logs messages passed to script command 'logmes'
@@ -385,33 +684,10 @@ void log_npc( struct npc_data* nd, const char* message ){
 		return;
 
 	if( log_config.sql_logs )
-	{
-		SqlStmt* stmt;
-		stmt = SqlStmt_Malloc(logmysql_handle);
-		if( SQL_SUCCESS != SqlStmt_Prepare(stmt, LOG_QUERY " INTO `%s` (`npc_date`, `char_name`, `map`, `mes`) VALUES (NOW(), ?, '%s', ?)", log_config.log_npc, map_mapid2mapname(nd->bl.m) )
-		||  SQL_SUCCESS != SqlStmt_BindParam(stmt, 0, SQLDT_STRING, nd->name, strnlen(nd->name, NAME_LENGTH))
-		||  SQL_SUCCESS != SqlStmt_BindParam(stmt, 1, SQLDT_STRING, (char*)message, safestrnlen(message, 255))
-		||  SQL_SUCCESS != SqlStmt_Execute(stmt) )
-		{
-			SqlStmt_ShowDebug(stmt);
-			SqlStmt_Free(stmt);
-			return;
-		}
-		SqlStmt_Free(stmt);
-	}
+		log_write_sql(log_config.log_npc, "`npc_date`, `char_name`, `map`, `mes`",
+			log_format("%s, '%s', '%s', '%s'", log_sql_now(), log_escape(nd->name, NAME_LENGTH).c_str(), map_mapid2mapname(nd->bl.m), log_escape(message, 255).c_str()));
 	else
-	{
-		char timestring[255];
-		time_t curtime;
-		FILE* logfp;
-
-		if( ( logfp = fopen(log_config.log_npc, "a") ) == NULL )
-			return;
-		time(&curtime);
-		strftime(timestring, sizeof(timestring), log_timestamp_format, localtime(&curtime));
-		fprintf(logfp, "%s - %s: %s\n", timestring, nd->name, message);
-		fclose(logfp);
-	}
+		log_write_file(log_config.log_npc, log_format("%s: %s\n", nd->name, message));
 }
 
 /// logs messages passed to script command 'logmes'
@@ -423,33 +699,10 @@ void log_npc(struct map_session_data* sd, const char* message)
 		return;
 
 	if( log_config.sql_logs )
-	{
-		SqlStmt* stmt;
-		stmt = SqlStmt_Malloc(logmysql_handle);
-		if( SQL_SUCCESS != SqlStmt_Prepare(stmt, LOG_QUERY " INTO `%s` (`npc_date`, `account_id`, `char_id`, `char_name`, `map`, `mes`) VALUES (NOW(), '%d', '%d', ?, '%s', ?)", log_config.log_npc, sd->status.account_id, sd->status.char_id, mapindex_id2name(sd->mapindex) )
-		||  SQL_SUCCESS != SqlStmt_BindParam(stmt, 0, SQLDT_STRING, sd->status.name, strnlen(sd->status.name, NAME_LENGTH))
-		||  SQL_SUCCESS != SqlStmt_BindParam(stmt, 1, SQLDT_STRING, (char*)message, safestrnlen(message, 255))
-		||  SQL_SUCCESS != SqlStmt_Execute(stmt) )
-		{
-			SqlStmt_ShowDebug(stmt);
-			SqlStmt_Free(stmt);
-			return;
-		}
-		SqlStmt_Free(stmt);
-	}
+		log_write_sql(log_config.log_npc, "`npc_date`, `account_id`, `char_id`, `char_name`, `map`, `mes`",
+			log_format("%s, '%d', '%d', '%s', '%s', '%s'", log_sql_now(), sd->status.account_id, sd->status.char_id, log_escape(sd->status.name, NAME_LENGTH).c_str(), mapindex_id2name(sd->mapindex), log_escape(message, 255).c_str()));
 	else
-	{
-		char timestring[255];
-		time_t curtime;
-		FILE* logfp;
-
-		if( ( logfp = fopen(log_config.log_npc, "a") ) == NULL )
-			return;
-		time(&curtime);
-		strftime(timestring, sizeof(timestring), log_timestamp_format, localtime(&curtime));
-		fprintf(logfp, "%s - %s[%d]: %s\n", timestring, sd->status.name, sd->status.account_id, message);
-		fclose(logfp);
-	}
+		log_write_file(log_config.log_npc, log_format("%s[%d]: %s\n", sd->status.name, sd->status.account_id, message));
 }
 
 
@@ -466,34 +719,11 @@ void log_chat(e_log_chat_type type, int type_id, int src_charid, int src_accid,
 		return;
 	}
 
-	if( log_config.sql_logs ) {
-		SqlStmt* stmt;
-
-		stmt = SqlStmt_Malloc(logmysql_handle);
-		if( SQL_SUCCESS != SqlStmt_Prepare(stmt, LOG_QUERY " INTO `%s` (`time`, `type`, `type_id`, `src_charid`, `src_accountid`, `src_map`, `src_map_x`, `src_map_y`, `dst_charname`, `message`) VALUES (NOW(), '%c', '%d', '%d', '%d', '%s', '%d', '%d', ?, ?)", log_config.log_chat, log_chattype2char(type), type_id, src_charid, src_accid, mapname, x, y)
-		||  SQL_SUCCESS != SqlStmt_BindParam(stmt, 0, SQLDT_STRING, (char*)dst_charname, safestrnlen(dst_charname, NAME_LENGTH))
-		||  SQL_SUCCESS != SqlStmt_BindParam(stmt, 1, SQLDT_STRING, (char*)message, safestrnlen(message, CHAT_SIZE_MAX))
-		||  SQL_SUCCESS != SqlStmt_Execute(stmt) )
-		{
-			SqlStmt_ShowDebug(stmt);
-			SqlStmt_Free(stmt);
-			return;
-		}
-		SqlStmt_Free(stmt);
-	}
+	if( log_config.sql_logs )
+		log_write_sql(log_config.log_chat, "`time`, `type`, `type_id`, `src_charid`, `src_accountid`, `src_map`, `src_map_x`, `src_map_y`, `dst_charname`, `message`",
+			log_format("%s, '%c', '%d', '%d', '%d', '%s', '%d', '%d', '%s', '%s'", log_sql_now(), log_chattype2char(type), type_id, src_charid, src_accid, mapname, x, y, log_escape(dst_charname, NAME_LENGTH).c_str(), log_escape(message, CHAT_SIZE_MAX).c_str()));
 	else
-	{
-		char timestring[255];
-		time_t curtime;
-		FILE* logfp;
-
-		if( ( logfp = fopen(log_config.log_chat, "a") ) == NULL )
-			return;
-		time(&curtime);
-		strftime(timestring, sizeof(timestring), log_timestamp_format, localtime(&curtime));
-		fprintf(logfp, "%s - %c,%d,%d,%d,%s,%d,%d,%s,%s\n", timestring, log_chattype2char(type), type_id, src_charid, src_accid, mapname, x, y, dst_charname, message);
-		fclose(logfp);
-	}
+		log_write_file(log_config.log_chat, log_format("%c,%d,%d,%d,%s,%d,%d,%s,%s\n", log_chattype2char(type), type_id, src_charid, src_accid, mapname, x, y, dst_charname, message));
 }
 
 /// logs cash transactions
@@ -503,25 +733,11 @@ void log_cash( struct map_session_data* sd, e_log_pick_type type, e_log_cash_typ
 	if( !log_config.cash )
 		return;
 
-	if( log_config.sql_logs ){
-		if( SQL_ERROR == Sql_Query( logmysql_handle, LOG_QUERY " INTO `%s` ( `time`, `char_id`, `type`, `cash_type`, `amount`, `map` ) VALUES ( NOW(), '%d', '%c', '%c', '%d', '%s' )",
-			log_config.log_cash, sd->status.char_id, log_picktype2char( type ), log_cashtype2char( cash_type ), amount, mapindex_id2name( sd->mapindex ) ) )
-		{
-			Sql_ShowDebug( logmysql_handle );
-			return;
-		}
-	}else{
-		char timestring[255];
-		time_t curtime;
-		FILE* logfp;
-
-		if( ( logfp = fopen( log_config.log_cash, "a" ) ) == NULL )
-			return;
-		time( &curtime );
-		strftime( timestring, sizeof( timestring ), log_timestamp_format, localtime( &curtime ) );
-		fprintf( logfp, "%s - %s[%d]\t%d(%c)\t\n", timestring, sd->status.name, sd->status.account_id, amount, log_cashtype2char( cash_type ) );
-		fclose( logfp );
-	}
+	if( log_config.sql_logs )
+		log_write_sql( log_config.log_cash, "`time`, `char_id`, `type`, `cash_type`, `amount`, `map`",
+			log_format( "%s, '%d', '%c', '%c', '%d', '%s'", log_sql_now(), sd->status.char_id, log_picktype2char( type ), log_cashtype2char( cash_type ), amount, mapindex_id2name( sd->mapindex ) ) );
+	else
+		log_write_file( log_config.log_cash, log_format( "%s[%d]\t%d(%c)\t\n", sd->status.name, sd->status.account_id, amount, log_cashtype2char( cash_type ) ) );
 }
 
 /**
@@ -556,27 +772,69 @@ void log_feeding(struct map_session_data *sd, e_log_feeding_type type, unsigned
 			break;
 	}
 
-	if (log_config.sql_logs) {
-		if (SQL_ERROR == Sql_Query(logmysql_handle, LOG_QUERY " INTO `%s` (`time`, `char_id`, `target_id`, `target_class`, `type`, `intimacy`, `item_id`, `map`, `x`, `y`) VALUES ( NOW(), '%" PRIu32 "', '%" PRIu32 "', '%hu', '%c', '%" PRIu32 "', '%hu', '%s', '%hu', '%hu' )",
-			log_config.log_feeding, sd->status.char_id, target_id, target_class, log_feedingtype2char(type), intimacy, nameid, mapindex_id2name(sd->mapindex), sd->bl.x, sd->bl.y))
-		{
-			Sql_ShowDebug(logmysql_handle);
-			return;
-		}
-	} else {
-		char timestring[255];
-		time_t curtime;
-		FILE* logfp;
+	if (log_config.sql_logs)
+		log_write_sql(log_config.log_feeding, "`time`, `char_id`, `target_id`, `target_class`, `type`, `intimacy`, `item_id`, `map`, `x`, `y`",
+			log_format("%s, '%" PRIu32 "', '%" PRIu32 "', '%hu', '%c', '%" PRIu32 "', '%hu', '%s', '%hu', '%hu'", log_sql_now(), sd->status.char_id, target_id, target_class, log_feedingtype2char(type), intimacy, nameid, mapindex_id2name(sd->mapindex), sd->bl.x, sd->bl.y));
+	else
+		log_write_file(log_config.log_feeding, log_format("%s[%d]\t%d\t%d(%c)\t%d\t%hu\t%s\t%hu,%hu\n", sd->status.name, sd->status.char_id, target_id, target_class, log_feedingtype2char(type), intimacy, nameid, mapindex_id2name(sd->mapindex), sd->bl.x, sd->bl.y));
+}
 
-		if ((logfp = fopen(log_config.log_feeding, "a")) == NULL)
-			return;
-		time(&curtime);
-		strftime(timestring, sizeof(timestring), log_timestamp_format, localtime(&curtime));
-		fprintf(logfp, "%s - %s[%d]\t%d\t%d(%c)\t%d\t%hu\t%s\t%hu,%hu\n", timestring, sd->status.name, sd->status.char_id, target_id, target_class, log_feedingtype2char(type), intimacy, nameid, mapindex_id2name(sd->mapindex), sd->bl.x, sd->bl.y);
-		fclose(logfp);
+/// starts the log writer thread, if enabled
+static void log_async_init(void)
+{
+	if( !log_config.async )
+		return;
+
+	log_async.ring.resize(log_config.async_queue);
+	log_async.head = 0;
+	log_async.tail = 0;
+	log_async.queued = 0;
+	log_async.dropped = 0;
+	log_async.running = true;
+	log_async.writer = new std::thread(log_async_writer);
+
+	ShowStatus("Writing logs from a background thread, queue of %d entries.\n", log_config.async_queue);
+}
+
+/// stops the log writer thread once it wrote all queued entries
+static void log_async_final(void)
+{
+	if( !log_async.running )
+		return;
+
+	log_async.running = false;
+	log_async.wakeup.notify_one();
+	log_async.writer->join();
+	delete log_async.writer;
+	log_async.writer = NULL;
+
+	log_async_report_errors();
+	if( log_async.dropped )
+		ShowWarning("Log writer: %" PRIu64 " of %" PRIu64 " log entries were dropped because the queue was full.\n", log_async.dropped, log_async.queued + log_async.dropped);
+
+	log_async.ring.clear();
+	log_async.ring.shrink_to_fit();
+}
+
+void do_init_log(void)
+{
+	log_async_init();
+
+	if( log_config.sql_logs && log_config.batch_rows > 1 )
+	{
+		add_timer_func_list(log_batch_timer, "log_batch_timer");
+		add_timer_interval(gettick() + log_config.batch_interval, log_batch_timer, 0, 0, log_config.batch_interval);
 	}
 }
 
+void do_final_log(void)
+{
+	// the batches go to the log writer, if any
+	log_batch_flush(log_batch_pick);
+	log_batch_flush(log_batch_zeny);
+	log_async_final();
+}
+
 void log_set_defaults(void)
 {
 	memset(&log_config, 0, sizeof(log_config));
@@ -587,6 +845,10 @@ void log_set_defaults(void)
 	log_config.price_items_log  = 1000; // 1000z
 	log_config.amount_items_log = 100;
 
+	log_config.async_queue = 8192;
+	log_config.batch_rows = 100;
+	log_config.batch_interval = 1000;
+
 	safestrncpy(log_timestamp_format, "%m/%d/%Y %H:%M:%S", sizeof(log_timestamp_format));
 }
 
@@ -617,6 +879,16 @@ int log_config_read(const char* cfgName)
 				log_config.enable_logs = (e_log_pick_type)config_switch(w2);
 			else if( strcmpi(w1, "sql_logs") == 0 )
 				log_config.sql_logs = config_switch(w2) > 0;
+			else if( strcmpi(w1, "log_async") == 0 )
+				log_config.async = config_switch(w2) > 0;
+			else if( strcmpi(w1, "log_async_queue") == 0 )
+				log_config.async_queue = atoi(w2);
+			else if( strcmpi(w1, "log_async_overflow") == 0 )
+				log_config.async_overflow = atoi(w2);
+			else if( strcmpi(w1, "log_batch_rows") == 0 )
+				log_config.batch_rows = atoi(w2);
+			else if( strcmpi(w1, "log_batch_interval") == 0 )
+				log_config.batch_interval = atoi(w2);
 //start of common filter settings
 			else if( strcmpi(w1, "rare_items_log") == 0 )
 				log_config.rare_items_log = atoi(w2);
@@ -682,6 +954,22 @@ int log_config_read(const char* cfgName)
 	{// report final logging state
 		const char* target = log_config.sql_logs ? "table" : "file";
 
+		if( log_config.async_queue < 64 )
+		{
+			ShowWarning("log_config_read: log_async_queue %d is too small, using 64.\n", log_config.async_queue);
+			log_config.async_queue = 64;
+		}
+		if( log_config.async_overflow != LOG_OVERFLOW_BLOCK && log_config.async_overflow != LOG_OVERFLOW_DROP )
+		{
+			ShowWarning("log_config_read: Invalid log_async_overflow %d, waiting for the log writer instead.\n", log_config.async_overflow);
+			log_config.async_overflow = LOG_OVERFLOW_BLOCK;
+		}
+		if( log_config.batch_interval < 100 )
+		{
+			ShowWarning("log_config_read: log_batch_interval %d is too small, using 100.\n", log_config.batch_interval);
+			log_config.batch_interval = 100;
+		}
+
 		if( log_config.enable_logs && log_config.filter )
 		{
 			ShowInfo("Logging item transactions to %s '%s'.\n", target, log_config.log_pick);
@@ -68,6 +68,13 @@ enum e_log_feeding_type : uint8
 	LOG_FEED_PET        = 0x2,
 };
 
+/// what to do when the queue of the log writer is full
+enum e_log_overflow : uint8
+{
+	LOG_OVERFLOW_BLOCK = 0, ///< wait for the log writer
+	LOG_OVERFLOW_DROP  = 1, ///< drop the entry
+};
+
 /// new logs
 void log_pick_pc(struct map_session_data* sd, e_log_pick_type type, int amount, struct item* itm);
 void log_pick_mob(struct mob_data* md, e_log_pick_type type, int amount, struct item* itm);
@@ -85,11 +92,17 @@ void log_mvpdrop(struct map_session_data* sd, int monster_id, unsigned int* log_
 
 int log_config_read(const char* cfgName);
 
+void do_init_log(void);
+void do_final_log(void);
+
 extern struct Log_Config
 {
 	e_log_pick_type enable_logs;
 	int filter;
 	bool sql_logs;
+	bool async;
+	int async_queue, async_overflow;
+	int batch_rows, batch_interval;
 	bool log_chat_woe_disable;
 	bool cash;
 	int rare_items_log,refine_items_log,price_items_log,amount_items_log; //for filter
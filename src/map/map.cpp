@@ -5,6 +5,8 @@
 
 #include <stdlib.h>
 #include <math.h>
+#include <unordered_map>
+#include <vector>
 
 #include "../common/cbasetypes.hpp"
 #include "../common/cli.hpp"
@@ -114,7 +116,10 @@ static DBMap* bossid_db=NULL; /// int id -> struct mob_data* (MVP db)
 static DBMap* map_db=NULL; /// unsigned int mapindex -> struct map_data*
 static DBMap* nick_db=NULL; /// uint32 char_id -> struct charid2nick* (requested names of offline characters)
 static DBMap* charid_db=NULL; /// uint32 char_id -> struct map_session_data*
-static DBMap* regen_db=NULL; /// int id -> struct block_list* (status_natural_heal processing)
+static std::vector<struct block_list*> regen_list; /// Objects with natural regeneration, packed for status_natural_heal processing
+static std::unordered_map<int, size_t> regen_index; /// int id -> position in regen_list
+static bool regen_list_locked = false; /// map_foreachregen is running, removed entries are only cleared
+static bool regen_list_holes = false;
 static DBMap* map_msg_db=NULL;
 
 static int map_users=0;
@@ -333,6 +338,52 @@ TIMER_FUNC(map_freeblock_timer){
  *------------------------------------------*/
 static struct block_list bl_head;
 
+/*==========================================
+ * Returns cell 'j' of the map for modification.
+ * Instance maps get a private copy of the page holding the cell first,
+ * other maps drop the copy of their cells shared with new instances.
+ *------------------------------------------*/
+static struct mapcell* map_cell_write(struct map_data* mapdata, int j)
+{
+	if (mapdata->cell_page.empty()) {
+		mapdata->cell_snapshot.reset();
+		return &mapdata->cell[j];
+	}
+
+	size_t page = j >> MAP_CELL_PAGE_SHIFT;
+
+	if (!mapdata->cell_page_private[page]) {
+		size_t count = min(MAP_CELL_PAGE_SIZE, mapdata->xs * mapdata->ys - (int)(page << MAP_CELL_PAGE_SHIFT));
+		struct mapcell* cells;
+
+		CREATE(cells, struct mapcell, count);
+		memcpy(cells, mapdata->cell_page[page], count * sizeof(struct mapcell));
+		mapdata->cell_page[page] = cells;
+		mapdata->cell_page_private[page] = true;
+	}
+
+	return &mapdata->cell_page[page][j & (MAP_CELL_PAGE_SIZE - 1)];
+}
+
+/*==========================================
+ * Frees the cells of a map, only the private pages for an instance map
+ *------------------------------------------*/
+static void map_free_cells(struct map_data* mapdata)
+{
+	if (!mapdata->cell_page.empty()) {
+		for (size_t i = 0; i < mapdata->cell_page.size(); i++) {
+			if (mapdata->cell_page_private[i])
+				aFree(mapdata->cell_page[i]);
+		}
+		mapdata->cell_page.clear();
+		mapdata->cell_page_private.clear();
+	} else if (mapdata->cell)
+		aFree(mapdata->cell);
+
+	mapdata->cell = NULL;
+	mapdata->cell_snapshot.reset();
+}
+
 #ifdef CELL_NOSTACK
 /*==========================================
  * These pair of functions update the counter of how many objects
@@ -344,7 +395,7 @@ static void map_addblcell(struct block_list *bl)
 
 	if( bl->m<0 || bl->x<0 || bl->x>=mapdata->xs || bl->y<0 || bl->y>=mapdata->ys || !(bl->type&BL_CHAR) )
 		return;
-	mapdata->cell[bl->x+bl->y*mapdata->xs].cell_bl++;
+	map_cell_write(mapdata, bl->x+bl->y*mapdata->xs)->cell_bl++;
 	return;
 }
 
@@ -354,7 +405,7 @@ static void map_delblcell(struct block_list *bl)
 
 	if( bl->m <0 || bl->x<0 || bl->x>=mapdata->xs || bl->y<0 || bl->y>=mapdata->ys || !(bl->type&BL_CHAR) )
 		return;
-	mapdata->cell[bl->x+bl->y*mapdata->xs].cell_bl--;
+	map_cell_write(mapdata, bl->x+bl->y*mapdata->xs)->cell_bl--;
 }
 #endif
 
@@ -2044,8 +2095,16 @@ void map_addiddb(struct block_list *bl)
 			idb_put(bossid_db, bl->id, bl);
 	}
 
-	if( bl->type & BL_REGEN )
-		idb_put(regen_db, bl->id, bl);
+	if( bl->type & BL_REGEN ) {
+		auto it = regen_index.find(bl->id);
+
+		if( it != regen_index.end() )
+			regen_list[it->second] = bl;
+		else {
+			regen_index[bl->id] = regen_list.size();
+			regen_list.push_back(bl);
+		}
+	}
 
 	idb_put(id_db,bl->id,bl);
 }
@@ -2069,8 +2128,24 @@ void map_deliddb(struct block_list *bl)
 		idb_remove(bossid_db,bl->id);
 	}
 
-	if( bl->type & BL_REGEN )
-		idb_remove(regen_db,bl->id);
+	if( bl->type & BL_REGEN ) {
+		auto it = regen_index.find(bl->id);
+
+		if( it != regen_index.end() ) {
+			size_t i = it->second;
+
+			regen_index.erase(it);
+			if( regen_list_locked ) { // keep the positions while iterating
+				regen_list[i] = NULL;
+				regen_list_holes = true;
+			} else {
+				regen_list[i] = regen_list.back();
+				regen_list.pop_back();
+				if( i < regen_list.size() )
+					regen_index[regen_list[i]->id] = i;
+			}
+		}
+	}
 
 	idb_remove(id_db,bl->id);
 }
@@ -2249,6 +2324,9 @@ int map_quit(struct map_session_data *sd) {
 	if (sd->state.buyingstore)
 		idb_remove(buyingstore_getdb(), sd->status.char_id);
 
+	// Kept shops are no longer listed, the player data is freed after the quit ack
+	searchstore_remove(sd);
+
 	pc_damage_log_clear(sd,0);
 	party_booking_delete(sd); // Party Booking [Spiria]
 	pc_makesavestatus(sd);
@@ -2495,22 +2573,38 @@ void map_foreachnpc(int (*func)(struct npc_data* nd, va_list args), ...)
 /// Stops iterating if func returns -1.
 void map_foreachregen(int (*func)(struct block_list* bl, va_list args), ...)
 {
-	DBIterator* iter;
-	struct block_list* bl;
+	regen_list_locked = true;
 
-	iter = db_iterator(regen_db);
-	for( bl = (struct block_list*)dbi_first(iter); dbi_exists(iter); bl = (struct block_list*)dbi_next(iter) )
+	// Objects added during the run are appended and processed as well
+	for( size_t i = 0; i < regen_list.size(); i++ )
 	{
 		va_list args;
 		int ret;
 
+		if( regen_list[i] == NULL )
+			continue;
+
 		va_start(args, func);
-		ret = func(bl, args);
+		ret = func(regen_list[i], args);
 		va_end(args);
 		if( ret == -1 )
 			break;// stop iterating
 	}
-	dbi_destroy(iter);
+
+	regen_list_locked = false;
+
+	if( regen_list_holes ) { // compact the entries removed during the run
+		size_t n = 0;
+
+		for( size_t i = 0; i < regen_list.size(); i++ ) {
+			if( regen_list[i] == NULL )
+				continue;
+			regen_index[regen_list[i]->id] = n;
+			regen_list[n++] = regen_list[i];
+		}
+		regen_list.resize(n);
+		regen_list_holes = false;
+	}
 }
 
 /// Applies func to everything in the db.
@@ -2804,11 +2898,25 @@ int map_addinstancemap(int src_m, int instance_id)
 	dst_map->npc_num_area = 0;
 	dst_map->npc_num_warp = 0;
 
-	// Reallocate cells
+	// Share the cells of the source map, pages are copied when the instance modifies them
 	size_t num_cell = dst_map->xs * dst_map->ys;
 
-	CREATE( dst_map->cell, struct mapcell, num_cell );
-	memcpy( dst_map->cell, src_map->cell, num_cell * sizeof(struct mapcell) );
+	if (!src_map->cell_snapshot) {
+		struct mapcell* snapshot;
+
+		CREATE(snapshot, struct mapcell, num_cell);
+		memcpy(snapshot, src_map->cell, num_cell * sizeof(struct mapcell));
+		src_map->cell_snapshot = std::shared_ptr<struct mapcell>(snapshot, [](struct mapcell* cells) { aFree(cells); });
+	}
+
+	size_t num_page = (num_cell + MAP_CELL_PAGE_SIZE - 1) >> MAP_CELL_PAGE_SHIFT;
+
+	dst_map->cell_snapshot = src_map->cell_snapshot;
+	dst_map->cell = dst_map->cell_snapshot.get(); // only read through cell_page
+	dst_map->cell_page.resize(num_page);
+	dst_map->cell_page_private.assign(num_page, false);
+	for (size_t i = 0; i < num_page; i++)
+		dst_map->cell_page[i] = dst_map->cell + (i << MAP_CELL_PAGE_SHIFT);
 
 	size_t size = dst_map->bxs * dst_map->bys * sizeof(struct block_list*);
 
@@ -2894,9 +3002,7 @@ int map_delinstancemap(int m)
 	mapdata->mob_delete_timer = INVALID_TIMER;
 
 	// Free memory
-	if (mapdata->cell)
-		aFree(mapdata->cell);
-	mapdata->cell = NULL;
+	map_free_cells(mapdata);
 	if (mapdata->block)
 		aFree(mapdata->block);
 	mapdata->block = NULL;
@@ -3264,7 +3370,12 @@ int map_getcellp(struct map_data* m,int16 x,int16 y,cell_chk cellchk)
 	if(x<0 || x>=m->xs-1 || y<0 || y>=m->ys-1)
 		return( cellchk == CELL_CHKNOPASS );
 
-	cell = m->cell[x + y*m->xs];
+	int j = x + y*m->xs;
+
+	if (m->cell_page.empty())
+		cell = m->cell[j];
+	else
+		cell = m->cell_page[j >> MAP_CELL_PAGE_SHIFT][j & (MAP_CELL_PAGE_SIZE - 1)];
 
 	switch(cellchk)
 	{
@@ -3341,18 +3452,20 @@ void map_setcell(int16 m, int16 x, int16 y, cell_t cell, bool flag)
 
 	j = x + y*mapdata->xs;
 
+	struct mapcell* c = map_cell_write(mapdata, j);
+
 	switch( cell ) {
-		case CELL_WALKABLE:      mapdata->cell[j].walkable = flag;      break;
-		case CELL_SHOOTABLE:     mapdata->cell[j].shootable = flag;     break;
-		case CELL_WATER:         mapdata->cell[j].water = flag;         break;
-
-		case CELL_NPC:           mapdata->cell[j].npc = flag;           break;
-		case CELL_BASILICA:      mapdata->cell[j].basilica = flag;      break;
-		case CELL_LANDPROTECTOR: mapdata->cell[j].landprotector = flag; break;
-		case CELL_NOVENDING:     mapdata->cell[j].novending = flag;     break;
-		case CELL_NOCHAT:        mapdata->cell[j].nochat = flag;        break;
-		case CELL_MAELSTROM:	 mapdata->cell[j].maelstrom = flag;	  break;
-		case CELL_ICEWALL:		 mapdata->cell[j].icewall = flag;		  break;
+		case CELL_WALKABLE:      c->walkable = flag;      break;
+		case CELL_SHOOTABLE:     c->shootable = flag;     break;
+		case CELL_WATER:         c->water = flag;         break;
+
+		case CELL_NPC:           c->npc = flag;           break;
+		case CELL_BASILICA:      c->basilica = flag;      break;
+		case CELL_LANDPROTECTOR: c->landprotector = flag; break;
+		case CELL_NOVENDING:     c->novending = flag;     break;
+		case CELL_NOCHAT:        c->nochat = flag;        break;
+		case CELL_MAELSTROM:	 c->maelstrom = flag;	  break;
+		case CELL_ICEWALL:		 c->icewall = flag;		  break;
 		default:
 			ShowWarning("map_setcell: invalid cell type '%d'\n", (int)cell);
 			break;
@@ -3371,9 +3484,12 @@ void map_setgatcell(int16 m, int16 x, int16 y, int gat)
 	j = x + y*mapdata->xs;
 
 	cell = map_gat2cell(gat);
-	mapdata->cell[j].walkable = cell.walkable;
-	mapdata->cell[j].shootable = cell.shootable;
-	mapdata->cell[j].water = cell.water;
+
+	struct mapcell* c = map_cell_write(mapdata, j);
+
+	c->walkable = cell.walkable;
+	c->shootable = cell.shootable;
+	c->water = cell.water;
 }
 
 /*==========================================
@@ -3972,6 +4088,22 @@ int map_readallmaps (void)
 	return 0;
 }
 
+/*==========================================
+ * Periodically appends the timer statistics to a file and starts a new window,
+ * see timer_stats_dump_interval
+ *------------------------------------------*/
+static TIMER_FUNC(map_timer_stats_timer){
+	int interval = battle_config.timer_stats_dump_interval;
+
+	if( timer_stats_enabled() && interval > 0 )
+		timer_stats_dump( "log/timer_stats.csv", true );
+	else
+		interval = 60; // Check again later, the configuration might have been reloaded
+
+	add_timer( gettick() + interval * 1000, map_timer_stats_timer, 0, 0 );
+	return 0;
+}
+
 ////////////////////////////////////////////////////////////////////////
 static int map_ip_set = 0;
 static int char_ip_set = 0;
@@ -4036,13 +4168,26 @@ int parse_console(const char* buf){
 	}
 	else if( strcmpi("ers_report", type) == 0 ){
 		ers_report();
+		tick_arena_report();
+	}
+	else if( strcmpi("timer_stats", type) == 0 ){
+		if( n < 2 )
+			timer_stats_report();
+		else if( strcmpi("on", command) == 0 || strcmpi("off", command) == 0 ){
+			battle_config.timer_stats = ( strcmpi("on", command) == 0 );
+			timer_stats_enable( battle_config.timer_stats != 0 );
+		}
+		else if( strcmpi("reset", command) == 0 )
+			timer_stats_reset();
 	}
 	else if( strcmpi("help", type) == 0 ) {
 		ShowInfo("Available commands:\n");
 		ShowInfo("\t admin:@<atcommand> => Uses an atcommand. Do NOT use commands requiring an attached player.\n");
 		ShowInfo("\t admin:map:<map> <x> <y> => Changes the map from which console commands are executed.\n");
 		ShowInfo("\t server:shutdown => Stops the server.\n");
-		ShowInfo("\t ers_report => Displays database usage.\n");
+		ShowInfo("\t ers_report => Displays database and tick arena usage.\n");
+		ShowInfo("\t timer_stats => Displays execution statistics of the timer functions.\n");
+		ShowInfo("\t timer_stats:<on|off|reset> => Starts, stops or resets the timer statistics.\n");
 	}
 
 	return 0;
@@ -4982,7 +5127,7 @@ void do_final(void){
 	for (int i = 0; i < map_num; i++) {
 		struct map_data *mapdata = map_getmapdata(i);
 
-		if(mapdata->cell) aFree(mapdata->cell);
+		map_free_cells(mapdata);
 		if(mapdata->block) aFree(mapdata->block);
 		if(mapdata->block_mob) aFree(mapdata->block_mob);
 		if(battle_config.dynamic_mobs) { //Dynamic mobs flag by [random]
@@ -5006,7 +5151,8 @@ void do_final(void){
 	nick_db->destroy(nick_db, nick_db_final);
 	charid_db->destroy(charid_db, NULL);
 	iwall_db->destroy(iwall_db, NULL);
-	regen_db->destroy(regen_db, NULL);
+	regen_list.clear();
+	regen_index.clear();
 
 // (^~_~^) Color Nicks Start
 
@@ -5015,6 +5161,7 @@ void do_final(void){
 
 // (^~_~^) Color Nicks End
 
+	do_final_log();
 	map_sql_close();
 
 	ShowStatus("Finished.\n");
@@ -5262,7 +5409,6 @@ int do_init(int argc, char *argv[])
 	map_db = uidb_alloc(DB_OPT_BASE);
 	nick_db = idb_alloc(DB_OPT_BASE);
 	charid_db = uidb_alloc(DB_OPT_BASE);
-	regen_db = idb_alloc(DB_OPT_BASE); // efficient status_natural_heal processing
 	iwall_db = strdb_alloc(DB_OPT_RELEASE_DATA,2*NAME_LENGTH+2+1); // [Zephyrus] Invisible Walls
 
 // (^~_~^) Color Nicks Start
@@ -5274,6 +5420,7 @@ int do_init(int argc, char *argv[])
 	map_sql_init();
 	if (log_config.sql_logs)
 		log_sql_init();
+	do_init_log();
 
 	mapindex_init();
 	if(enable_grf)
@@ -5284,7 +5431,9 @@ int do_init(int argc, char *argv[])
 	add_timer_func_list(map_freeblock_timer, "map_freeblock_timer");
 	add_timer_func_list(map_clearflooritem_timer, "map_clearflooritem_timer");
 	add_timer_func_list(map_removemobs_timer, "map_removemobs_timer");
+	add_timer_func_list(map_timer_stats_timer, "map_timer_stats_timer");
 	add_timer_interval(gettick()+1000, map_freeblock_timer, 0, 0, 60*1000);
+	add_timer(gettick()+60*1000, map_timer_stats_timer, 0, 0);
 	
 	map_do_init_msg();
 	do_init_path();
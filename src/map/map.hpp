@@ -5,6 +5,7 @@
 #define MAP_HPP
 
 #include <algorithm>
+#include <memory>
 #include <stdarg.h>
 #include <unordered_map>
 #include <vector>
@@ -704,6 +705,10 @@ struct mapcell
 #endif
 };
 
+// Instance maps share the cells of their source map and copy them on write, in pages of this many cells
+#define MAP_CELL_PAGE_SHIFT 10
+#define MAP_CELL_PAGE_SIZE (1 << MAP_CELL_PAGE_SHIFT)
+
 struct iwall_data {
 	char wall_name[50];
 	short m, x, y, size;
@@ -750,6 +755,9 @@ struct map_data {
 	// Instance Variables
 	int instance_id;
 	int instance_src_map;
+	std::shared_ptr<struct mapcell> cell_snapshot; // Source map: copy of its cells shared by its instances. Instance map: the copy it reads from.
+	std::vector<struct mapcell*> cell_page; // Instance map: each page points into cell_snapshot or to a private copy
+	std::vector<bool> cell_page_private; // Instance map: whether the page was copied on write
 
 	/* rAthena Local Chat */
 	struct Channel *channel;
@@ -1173,6 +1181,13 @@ extern Sql* mmysql_handle;
 extern Sql* qsmysql_handle;
 extern Sql* logmysql_handle;
 
+extern char log_db_ip[64];
+extern int log_db_port;
+extern char log_db_id[32];
+extern char log_db_pw[32];
+extern char log_db_db[32];
+extern char default_codepage[32];
+
 extern char buyingstores_table[32];
 extern char buyingstore_items_table[32];
 extern char item_table[32];
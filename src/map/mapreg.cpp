@@ -4,6 +4,7 @@
 #include "mapreg.hpp"
 
 #include <stdlib.h>
+#include <vector>
 
 #include "../common/cbasetypes.hpp"
 #include "../common/db.hpp"
@@ -22,10 +23,27 @@ static struct eri *mapreg_ers;
 bool skip_insert = false;
 
 static char mapreg_table[32] = "mapreg";
-static bool mapreg_dirty = false; // Whether there are modified regs to be saved
+static std::vector<int64> mapreg_dirty_list; // uids of modified regs to be saved, the reg may have been removed since
+static int mapreg_save_timer = INVALID_TIMER; // Saves the dirty regs in steps after an autosave
 struct reg_db regs;
 
 #define MAPREG_AUTOSAVE_INTERVAL (300*1000)
+#define MAPREG_SAVE_BATCH 500 // Regs saved per statement
+#define MAPREG_SAVE_STEP_INTERVAL 50 // Delay between the statements of an autosave
+
+
+/**
+ * Flags a permanent variable to be saved.
+ *
+ * @param m: variable
+ */
+static void mapreg_flag_dirty(struct mapreg_save *m)
+{
+	if (!m->save) {
+		m->save = true;
+		mapreg_dirty_list.push_back(m->uid);
+	}
+}
 
 
 /**
@@ -69,10 +87,8 @@ bool mapreg_setreg(int64 uid, int64 val)
 	if (val != 0) {
 		if ((m = static_cast<mapreg_save *>(i64db_get(regs.vars, uid)))) {
 			m->u.i = val;
-			if (name[1] != '@') {
-				m->save = true;
-				mapreg_dirty = true;
-			}
+			if (name[1] != '@')
+				mapreg_flag_dirty(m);
 		} else {
 			if (i)
 				script_array_update(&regs, uid, false);
@@ -145,10 +161,8 @@ bool mapreg_setregstr(int64 uid, const char* str)
 			if (m->u.str != NULL)
 				aFree(m->u.str);
 			m->u.str = aStrdup(str);
-			if (name[1] != '@') {
-				mapreg_dirty = true;
-				m->save = true;
-			}
+			if (name[1] != '@')
+				mapreg_flag_dirty(m);
 		} else {
 			if (i)
 				script_array_update(&regs, uid, false);
@@ -224,48 +238,86 @@ static void script_load_mapreg(void)
 	SqlStmt_Free(stmt);
 
 	skip_insert = false;
-	mapreg_dirty = false;
 }
 
 /**
- * Saves permanent variables to database.
+ * Saves modified permanent variables to database with one multi-row REPLACE.
+ *
+ * @param limit: maximum number of variables to save
  */
-static void script_save_mapreg(void)
+static void script_save_mapreg_batch(size_t limit)
 {
-	if (mapreg_dirty) {
-		DBIterator *iter = db_iterator(regs.vars);
-		struct mapreg_save *m;
-		for (m = static_cast<mapreg_save *>(dbi_first(iter)); dbi_exists(iter); m = static_cast<mapreg_save *>(dbi_next(iter))) {
-			if (m->save) {
-				int num = script_getvarid(m->uid);
-				uint32 i = script_getvaridx(m->uid);
-				const char* name = get_str(num);
-				if (!m->is_string) {
-					char esc_name[32 * 2 + 1];
-					Sql_EscapeStringLen(mmysql_handle, esc_name, name, strnlen(name, 32));
-					if (SQL_ERROR == Sql_Query(mmysql_handle, "UPDATE `%s` SET `value`='%" PRId64 "' WHERE `varname`='%s' AND `index`='%" PRIu32 "' LIMIT 1", mapreg_table, m->u.i, esc_name, i))
-						Sql_ShowDebug(mmysql_handle);
-				} else {
-					char esc_str[2 * 255 + 1];
-					char esc_name[32 * 2 + 1];
-					Sql_EscapeStringLen(mmysql_handle, esc_name, name, strnlen(name, 32));
-					Sql_EscapeStringLen(mmysql_handle, esc_str, m->u.str, safestrnlen(m->u.str, 255));
-					if (SQL_ERROR == Sql_Query(mmysql_handle, "UPDATE `%s` SET `value`='%s' WHERE `varname`='%s' AND `index`='%" PRIu32 "' LIMIT 1", mapreg_table, esc_str, esc_name, i))
-						Sql_ShowDebug(mmysql_handle);
-				}
-				m->save = false;
-			}
+	StringBuf buf;
+	size_t count = 0;
+
+	StringBuf_Init(&buf);
+
+	while (!mapreg_dirty_list.empty() && count < limit) {
+		struct mapreg_save *m = static_cast<mapreg_save *>(i64db_get(regs.vars, mapreg_dirty_list.back()));
+
+		mapreg_dirty_list.pop_back();
+
+		if (m == NULL || !m->save) // removed, or removed and inserted again since
+			continue;
+
+		int num = script_getvarid(m->uid);
+		uint32 i = script_getvaridx(m->uid);
+		const char* name = get_str(num);
+		char esc_name[32 * 2 + 1];
+
+		Sql_EscapeStringLen(mmysql_handle, esc_name, name, strnlen(name, 32));
+
+		if (count++ == 0)
+			StringBuf_Printf(&buf, "REPLACE INTO `%s` (`varname`,`index`,`value`) VALUES ", mapreg_table);
+		else
+			StringBuf_AppendStr(&buf, ",");
+
+		if (!m->is_string)
+			StringBuf_Printf(&buf, "('%s','%" PRIu32 "','%" PRId64 "')", esc_name, i, m->u.i);
+		else {
+			char esc_str[2 * 255 + 1];
+
+			Sql_EscapeStringLen(mmysql_handle, esc_str, m->u.str, safestrnlen(m->u.str, 255));
+			StringBuf_Printf(&buf, "('%s','%" PRIu32 "','%s')", esc_name, i, esc_str);
 		}
-		dbi_destroy(iter);
-		mapreg_dirty = false;
+		m->save = false;
 	}
+
+	if (count > 0 && SQL_ERROR == Sql_QueryStr(mmysql_handle, StringBuf_Value(&buf)))
+		Sql_ShowDebug(mmysql_handle);
+
+	StringBuf_Destroy(&buf);
+}
+
+/**
+ * Saves all modified permanent variables to database.
+ */
+static void script_save_mapreg(void)
+{
+	while (!mapreg_dirty_list.empty())
+		script_save_mapreg_batch(MAPREG_SAVE_BATCH);
+}
+
+/**
+ * Timer event saving the next batch of modified permanent variables.
+ */
+static TIMER_FUNC(script_autosave_mapreg_step){
+	script_save_mapreg_batch(MAPREG_SAVE_BATCH);
+
+	if (!mapreg_dirty_list.empty())
+		mapreg_save_timer = add_timer(tick + MAPREG_SAVE_STEP_INTERVAL, script_autosave_mapreg_step, 0, 0, TIMER_PRIORITY_BACKGROUND);
+	else
+		mapreg_save_timer = INVALID_TIMER;
+	return 0;
 }
 
 /**
  * Timer event to auto-save permanent variables.
+ * The save is spread over several ticks, MAPREG_SAVE_BATCH variables at a time.
  */
 static TIMER_FUNC(script_autosave_mapreg){
-	script_save_mapreg();
+	if (mapreg_save_timer == INVALID_TIMER && !mapreg_dirty_list.empty())
+		mapreg_save_timer = add_timer(tick, script_autosave_mapreg_step, 0, 0, TIMER_PRIORITY_BACKGROUND);
 	return 0;
 }
 
@@ -317,6 +369,11 @@ void mapreg_reload(void)
  */
 void mapreg_final(void)
 {
+	if (mapreg_save_timer != INVALID_TIMER) {
+		delete_timer(mapreg_save_timer, script_autosave_mapreg_step);
+		mapreg_save_timer = INVALID_TIMER;
+	}
+
 	script_save_mapreg();
 
 	regs.vars->destroy(regs.vars, mapreg_destroyreg);
@@ -341,7 +398,8 @@ void mapreg_init(void)
 	script_load_mapreg();
 
 	add_timer_func_list(script_autosave_mapreg, "script_autosave_mapreg");
-	add_timer_interval(gettick() + MAPREG_AUTOSAVE_INTERVAL, script_autosave_mapreg, 0, 0, MAPREG_AUTOSAVE_INTERVAL);
+	add_timer_func_list(script_autosave_mapreg_step, "script_autosave_mapreg_step");
+	add_timer_interval(gettick() + MAPREG_AUTOSAVE_INTERVAL, script_autosave_mapreg, 0, 0, MAPREG_AUTOSAVE_INTERVAL, TIMER_PRIORITY_BACKGROUND);
 }
 
 /**
@@ -14,7 +14,7 @@ struct mapreg_save {
 		char *str;     ///< String value
 	} u;
 	bool is_string;    ///< true if it's a string, false if it's a number
-	bool save;         ///< Whether a save operation is pending
+	bool save;         ///< Whether a save operation is pending (the uid is in the dirty list)
 };
 
 extern struct reg_db regs;
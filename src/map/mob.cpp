@@ -8,6 +8,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "../common/cbasetypes.hpp"
@@ -104,6 +105,10 @@ static DBMap *mob_skill_db; /// Monster skill temporary db. s_mob_skill -> mobid
 static struct eri *item_drop_ers; //For loot drops delay structures.
 static struct eri *item_drop_list_ers;
 
+// Monsters that need the lazy AI between two full sweeps (spotted by a player, recently active or slaves)
+static std::unordered_set<int> mob_ai_active;
+static int mob_ai_lazy_count = 0; // lazy AI intervals since the last full sweep
+
 struct s_randomsummon_entry {
 	uint16 mob_id;
 	uint32 rate;
@@ -1977,6 +1982,7 @@ static int mob_ai_sub_hard_timer(struct block_list *bl,va_list ap)
 	{	//Hard AI triggered.
 		mob_add_spotted(md, char_id);
 		md->last_pcneartime = tick;
+		mob_ai_active.insert(md->bl.id);
 	}
 	return 0;
 }
@@ -1995,15 +2001,11 @@ static int mob_ai_sub_foreachclient(struct map_session_data *sd,va_list ap)
 /*==========================================
  * Negligent mode MOB AI (PC is not in near)
  *------------------------------------------*/
-static int mob_ai_sub_lazy(struct mob_data *md, va_list args)
+static int mob_ai_lazy_sub(struct mob_data *md, t_tick tick)
 {
-	nullpo_ret(md);
-
 	if(md->bl.prev == NULL)
 		return 0;
 
-	t_tick tick = va_arg(args,t_tick);
-
 	if (battle_config.mob_ai&0x20 && map_getmapdata(md->bl.m)->users>0)
 		return (int)mob_ai_sub_hard(md, tick);
 
@@ -2068,11 +2070,62 @@ static int mob_ai_sub_lazy(struct mob_data *md, va_list args)
 	return 0;
 }
 
+/**
+ * Checks if a monster has to be processed by the lazy AI between two full sweeps.
+ * Monsters that were never spotted and are no slaves do nothing while no player is around.
+ * @param md: Monster to check
+ * @return True if the monster is active
+ */
+static bool mob_ai_is_active(struct mob_data *md)
+{
+	if (md->bl.prev == NULL || md->status.hp == 0)
+		return false;
+
+	return md->master_id || md->last_pcneartime || mob_is_spotted(md);
+}
+
+static int mob_ai_sub_lazy(struct mob_data *md, va_list args)
+{
+	nullpo_ret(md);
+
+	t_tick tick = va_arg(args,t_tick);
+	int ret = mob_ai_lazy_sub(md, tick);
+
+	// Keep the active set in sync with the monsters seen during a full sweep
+	if (mob_ai_is_active(md))
+		mob_ai_active.insert(md->bl.id);
+	else
+		mob_ai_active.erase(md->bl.id);
+
+	return ret;
+}
+
 /*==========================================
  * Negligent processing for mob outside PC field of view   (interval timer function)
+ * All monsters are only checked every mob_lazy_sweep_interval runs,
+ * in between only the active ones are processed.
  *------------------------------------------*/
 static TIMER_FUNC(mob_ai_lazy){
-	map_foreachmob(mob_ai_sub_lazy,tick);
+	if (battle_config.mob_lazy_sweep_interval <= 1 || ++mob_ai_lazy_count >= battle_config.mob_lazy_sweep_interval) {
+		mob_ai_lazy_count = 0;
+		map_foreachmob(mob_ai_sub_lazy,tick);
+		return 0;
+	}
+
+	// Monsters might die or be removed while processing, so work on a copy
+	std::vector<int> list( mob_ai_active.begin(), mob_ai_active.end() );
+
+	for (int id : list) {
+		struct mob_data *md = map_id2md(id);
+
+		if (md != nullptr)
+			mob_ai_lazy_sub(md, tick);
+
+		// Look it up again, the monster might have been removed in the meantime
+		if ((md = map_id2md(id)) == nullptr || !mob_ai_is_active(md))
+			mob_ai_active.erase(id);
+	}
+
 	return 0;
 }
 
@@ -5739,7 +5792,7 @@ void do_init_mob(void){
 	add_timer_func_list(mob_respawn,"mob_respawn");
 	add_timer_func_list(mvptomb_delayspawn,"mvptomb_delayspawn");
 	add_timer_interval(gettick()+MIN_MOBTHINKTIME,mob_ai_hard,0,0,MIN_MOBTHINKTIME);
-	add_timer_interval(gettick()+MIN_MOBTHINKTIME*10,mob_ai_lazy,0,0,MIN_MOBTHINKTIME*10);
+	add_timer_interval(gettick()+MIN_MOBTHINKTIME*10,mob_ai_lazy,0,0,MIN_MOBTHINKTIME*10,TIMER_PRIORITY_BACKGROUND);
 }
 
 /*==========================================
@@ -3,6 +3,7 @@
 
 #include "pc.hpp"
 
+#include <deque>
 #include <map>
 
 #include <math.h>
@@ -10194,7 +10195,7 @@ static int pc_checkcombo(struct map_session_data *sd, struct item_data *data) {
 		nb_itemCombo = data->combos[i]->count;
 		if(nb_itemCombo<2) //a combo with less then 2 item ?? how that possible
 			continue;
-		CREATE(combo_idx,struct itemchk,nb_itemCombo);
+		TICK_CREATE(combo_idx,struct itemchk,nb_itemCombo);
 		for(j=0; j < nb_itemCombo; j++){
 			combo_idx[j].idx=-1;
 			combo_idx[j].nameid=-1;
@@ -10266,7 +10267,6 @@ static int pc_checkcombo(struct map_session_data *sd, struct item_data *data) {
 			if( !found )
 				break;/* we haven't found all the ids for this combo, so we can return */
 		}
-		aFree(combo_idx);
 		/* means we broke out of the count loop w/o finding all ids, we can move to the next combo */
 		if( j < nb_itemCombo )
 			continue;
@@ -11383,7 +11383,7 @@ static TIMER_FUNC(pc_autosave){
 	interval = autosave_interval/(map_usercount()+1);
 	if(interval < minsave_interval)
 		interval = minsave_interval;
-	add_timer(gettick()+interval,pc_autosave,0,0);
+	add_timer(gettick()+interval,pc_autosave,0,0,TIMER_PRIORITY_BACKGROUND);
 
 	return 0;
 }
@@ -12640,6 +12640,63 @@ TIMER_FUNC(pc_autotrade_timer){
 	return 0;
 }
 
+#define AUTOTRADE_RESTORE_INTERVAL 100 // Interval used to log in the next restored autotraders (ms)
+
+static std::deque<struct map_session_data*> autotrade_restore_queue; // Restored autotraders waiting for their login
+static int autotrade_restore_tid = INVALID_TIMER;
+
+/**
+ * Requests the login of the next restored autotraders, paced by feature.autotrade_restore_rate
+ */
+static TIMER_FUNC(pc_autotrade_restore_timer){
+	autotrade_restore_tid = INVALID_TIMER;
+
+	if (chrif_isconnected()) { // otherwise retry once the char-server is back
+		size_t count = autotrade_restore_queue.size();
+
+		if (battle_config.feature_autotrade_restore_rate > 0) {
+			int64 rate = (int64)battle_config.feature_autotrade_restore_rate * AUTOTRADE_RESTORE_INTERVAL / 1000;
+
+			count = min(count, (size_t)(rate > 0 ? rate : 1));
+		}
+
+		for (; count > 0; count--) {
+			struct map_session_data *sd = autotrade_restore_queue.front();
+
+			autotrade_restore_queue.pop_front();
+
+			// The account logged in meanwhile, its character is not restored as autotrader
+			if (map_id2sd(sd->status.account_id) || chrif_search(sd->status.account_id)) {
+				ShowInfo("pc_autotrade_restore_timer: Account %d is already online, autotrader %d is not restored.\n", sd->status.account_id, sd->status.char_id);
+				vending_autotrader_discard(sd);
+				buyingstore_autotrader_discard(sd);
+				aFree(sd); // not logged in yet
+				continue;
+			}
+
+			chrif_authreq(sd, true);
+		}
+	}
+
+	if (!autotrade_restore_queue.empty())
+		autotrade_restore_tid = add_timer(tick + AUTOTRADE_RESTORE_INTERVAL, pc_autotrade_restore_timer, 0, 0);
+
+	return 0;
+}
+
+/**
+ * Queues the login of an autotrader restored after a restart
+ * @param sd: Autotrader, not logged in yet
+ */
+void pc_autotrade_restore(struct map_session_data *sd) {
+	nullpo_retv(sd);
+
+	autotrade_restore_queue.push_back(sd);
+
+	if (autotrade_restore_tid == INVALID_TIMER)
+		autotrade_restore_tid = add_timer(gettick(), pc_autotrade_restore_timer, 0, 0);
+}
+
 /* this timer exists only when a character with a expire timer > 24h is online */
 /* it loops thru online players once an hour to check whether a new < 24h is available */
 TIMER_FUNC(pc_global_expiration_timer){
@@ -13529,9 +13586,10 @@ void do_init_pc(void) {
 	add_timer_func_list(pc_global_expiration_timer, "pc_global_expiration_timer");
 	add_timer_func_list(pc_expiration_timer, "pc_expiration_timer");
 	add_timer_func_list(pc_autotrade_timer, "pc_autotrade_timer");
+	add_timer_func_list(pc_autotrade_restore_timer, "pc_autotrade_restore_timer");
 	add_timer_func_list(pc_on_expire_active, "pc_on_expire_active");
 
-	add_timer(gettick() + autosave_interval, pc_autosave, 0, 0);
+	add_timer(gettick() + autosave_interval, pc_autosave, 0, 0, TIMER_PRIORITY_BACKGROUND);
 
 	// 0=day, 1=night [Yor]
 	night_flag = battle_config.night_at_start ? 1 : 0;
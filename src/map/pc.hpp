@@ -690,6 +690,8 @@ struct map_session_data {
 	bool *qi_display;
 	int qi_count;
 
+	struct s_inventorylist_cache *inventorylist_cache; ///< Encoded clif_inventorylist entries per inventory index, allocated on first use
+
 	// temporary debug [flaviojs]
 	const char* debug_file;
 	int debug_line;
@@ -752,6 +754,8 @@ struct map_session_data {
 	unsigned char vars_received; // char loading is only complete when you get it all.
 	bool vars_ok;
 	bool vars_dirty;
+	struct mmo_charstatus* save_base; ///< Status last sent to the char-server, base of the next delta save
+	struct item *inventory_base, *cart_base, *storage_base, *premium_storage_base; ///< Items last sent to or received from the char-server, saves are skipped while unchanged
 
 	uint16 dmglog[DAMAGELOG_SIZE_PC]; ///target ids
 
@@ -1419,6 +1423,7 @@ bool pc_is_same_equip_index(enum equip_index eqi, short *equip_index, short inde
 #define pc_is_taekwon_ranker(sd) (((sd)->class_&MAPID_UPPERMASK) == MAPID_TAEKWON && (sd)->status.base_level >= battle_config.taekwon_ranker_min_lv && pc_famerank((sd)->status.char_id,MAPID_TAEKWON))
 
 TIMER_FUNC(pc_autotrade_timer);
+void pc_autotrade_restore(struct map_session_data *sd);
 
 void pc_validate_skill(struct map_session_data *sd);
 
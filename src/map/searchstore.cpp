@@ -3,8 +3,15 @@
 
 #include "searchstore.hpp"  // struct s_search_store_info
 
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
 #include "../common/cbasetypes.hpp"
 #include "../common/malloc.hpp"  // aMalloc, aRealloc, aFree
+#include "../common/nullpo.hpp"
 #include "../common/showmsg.hpp"  // ShowError, ShowWarning
 #include "../common/strlib.hpp"  // safestrncpy
 
@@ -22,13 +29,6 @@ enum e_searchstore_failure
 	SSI_FAILED_SSILIST_CLICK_TO_OPEN_STORE = 4,  // "No sale (purchase) information available."
 };
 
-/// Search type constants
-enum e_searchstore_searchtype
-{
-	SEARCHTYPE_VENDING      = 0,
-	SEARCHTYPE_BUYING_STORE = 1,
-};
-
 /// Search effect constants
 enum e_searchstore_effecttype
 {
@@ -41,6 +41,14 @@ enum e_searchstore_effecttype
 typedef bool (*searchstore_search_t)(struct map_session_data* sd, unsigned short nameid);
 typedef bool (*searchstore_searchall_t)(struct map_session_data* sd, const struct s_search_store_search* s);
 
+/// Open stores by item, so that a query only visits the stores dealing in the wanted items
+struct s_searchstore_index {
+	std::unordered_map<unsigned short, std::multimap<unsigned int, struct map_session_data*>> items; // nameid -> price -> store owner
+	std::unordered_map<uint32, std::vector<std::pair<unsigned short, unsigned int>>> stores; // char_id -> indexed nameid and price
+};
+
+static struct s_searchstore_index searchstore_index[SEARCHTYPE_MAX];
+
 /**
  * Retrieves search function by type.
  * @param type : type of search to conduct
@@ -141,8 +149,6 @@ bool searchstore_open(struct map_session_data* sd, unsigned int uses, unsigned s
 void searchstore_query(struct map_session_data* sd, unsigned char type, unsigned int min_price, unsigned int max_price, const unsigned short* itemlist, unsigned int item_count, const unsigned short* cardlist, unsigned int card_count)
 {
 	unsigned int i;
-	struct map_session_data* pl_sd;
-	struct DBIterator *iter;
 	struct s_search_store_search s;
 	searchstore_searchall_t store_searchall;
 	time_t querytime;
@@ -199,28 +205,39 @@ void searchstore_query(struct map_session_data* sd, unsigned char type, unsigned
 	// allocate max. amount of results
 	sd->searchstore.items = (struct s_search_store_info_item*)aMalloc(sizeof(struct s_search_store_info_item)*battle_config.searchstore_maxresults);
 
-	// search
+	// search one item at a time, visiting only the stores indexed for it within the price range
 	s.search_sd  = sd;
-	s.itemlist   = itemlist;
 	s.cardlist   = cardlist;
-	s.item_count = item_count;
+	s.item_count = 1;
 	s.card_count = card_count;
 	s.min_price  = min_price;
 	s.max_price  = max_price;
-	iter         = db_iterator((type == SEARCHTYPE_VENDING) ? vending_getdb() : buyingstore_getdb());
 
-	for( pl_sd = (struct map_session_data*)dbi_first(iter); dbi_exists(iter);  pl_sd = (struct map_session_data*)dbi_next(iter) ) {
-		if( sd == pl_sd ) // skip own shop, if any
+	for( i = 0; i < item_count; i++ ) {
+		auto item = searchstore_index[type].items.find(itemlist[i]);
+
+		if( item == searchstore_index[type].items.end() )
 			continue;
 
-		if( !store_searchall(pl_sd, &s) ) { // exceeded result size
+		auto it = item->second.lower_bound(min_price);
+		auto last = max_price ? item->second.upper_bound(max_price) : item->second.end();
+
+		s.itemlist = &itemlist[i];
+
+		for( ; it != last; ++it ) {
+			if( sd == it->second ) // skip own shop, if any
+				continue;
+
+			if( !store_searchall(it->second, &s) ) // exceeded result size
+				break;
+		}
+
+		if( it != last ) {
 			clif_search_store_info_failed(sd, SSI_FAILED_OVER_MAXCOUNT);
 			break;
 		}
 	}
 
-	dbi_destroy(iter);
-
 	if( sd->searchstore.count ) {
 		// reclaim unused memory
 		sd->searchstore.items = (struct s_search_store_info_item*)aRealloc(sd->searchstore.items, sizeof(struct s_search_store_info_item)*sd->searchstore.count);
@@ -419,3 +436,107 @@ bool searchstore_result(struct map_session_data* sd, int store_id, uint32 accoun
 
 	return true;
 }
+
+/**
+ * Removes the entries of a player's store from a search index.
+ * @param index : search index
+ * @param sd : store owner
+ */
+static void searchstore_index_remove(struct s_searchstore_index* index, struct map_session_data* sd)
+{
+	auto store = index->stores.find(sd->status.char_id);
+
+	if( store == index->stores.end() )
+		return;
+
+	for( const auto& entry : store->second ) {
+		auto item = index->items.find(entry.first);
+
+		if( item == index->items.end() )
+			continue;
+
+		auto range = item->second.equal_range(entry.second);
+
+		for( auto it = range.first; it != range.second; ++it ) {
+			if( it->second == sd ) {
+				item->second.erase(it);
+				break;
+			}
+		}
+
+		if( item->second.empty() )
+			index->items.erase(item);
+	}
+
+	index->stores.erase(store);
+}
+
+/**
+ * Removes a player's stores from all search indexes, regardless of the store state.
+ * Call before the player data is freed.
+ * @param sd : store owner
+ */
+void searchstore_remove(struct map_session_data* sd)
+{
+	nullpo_retv(sd);
+
+	for( int type = 0; type < SEARCHTYPE_MAX; type++ )
+		searchstore_index_remove(&searchstore_index[type], sd);
+}
+
+/**
+ * Updates the search index for a player's store, call after opening, changing or closing it.
+ * Only the first slot with an item is indexed, as that is the one the store-specific search checks.
+ * @param sd : store owner
+ * @param type : shop type
+ */
+void searchstore_update(struct map_session_data* sd, unsigned char type)
+{
+	struct s_searchstore_index* index;
+
+	nullpo_retv(sd);
+
+	if( type >= SEARCHTYPE_MAX )
+		return;
+
+	index = &searchstore_index[type];
+
+	// remove the previous entries
+	searchstore_index_remove(index, sd);
+
+	if( !searchstore_hasstore(sd, type) )
+		return;
+
+	std::vector<std::pair<unsigned short, unsigned int>> entries;
+	int i;
+
+	switch( type ) {
+		case SEARCHTYPE_VENDING:
+			for( i = 0; i < sd->vend_num; i++ ) {
+				unsigned short nameid = sd->cart.u.items_cart[sd->vending[i].index].nameid;
+
+				if( std::find_if(entries.begin(), entries.end(), [nameid](const std::pair<unsigned short, unsigned int>& entry) { return entry.first == nameid; }) == entries.end() )
+					entries.push_back(std::make_pair(nameid, sd->vending[i].value));
+			}
+			break;
+		case SEARCHTYPE_BUYING_STORE:
+			for( i = 0; i < sd->buyingstore.slots; i++ ) {
+				unsigned short nameid = sd->buyingstore.items[i].nameid;
+
+				if( !sd->buyingstore.items[i].amount )
+					continue;
+
+				if( std::find_if(entries.begin(), entries.end(), [nameid](const std::pair<unsigned short, unsigned int>& entry) { return entry.first == nameid; }) == entries.end() )
+					entries.push_back(std::make_pair(nameid, (unsigned int)sd->buyingstore.items[i].price));
+			}
+			break;
+	}
+
+	if( entries.empty() )
+		return;
+
+	for( const auto& entry : entries )
+		index->items[entry.first].insert(std::make_pair(entry.second, sd));
+
+	index->stores[sd->status.char_id] = std::move(entries);
+}
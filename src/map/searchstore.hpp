@@ -11,6 +11,14 @@
 
 #define SEARCHSTORE_RESULTS_PER_PAGE 10
 
+/// Search type constants
+enum e_searchstore_searchtype
+{
+	SEARCHTYPE_VENDING      = 0,
+	SEARCHTYPE_BUYING_STORE = 1,
+	SEARCHTYPE_MAX
+};
+
 /// information about the search being performed
 struct s_search_store_search {
 	struct map_session_data* search_sd;  // sd of the searching player
@@ -55,5 +63,7 @@ void searchstore_click(struct map_session_data* sd, uint32 account_id, int store
 bool searchstore_queryremote(struct map_session_data* sd, uint32 account_id);
 void searchstore_clearremote(struct map_session_data* sd);
 bool searchstore_result(struct map_session_data* sd, int store_id, uint32 account_id, const char* store_name, unsigned short nameid, unsigned short amount, unsigned int price, const unsigned short* card, unsigned char refine);
+void searchstore_update(struct map_session_data* sd, unsigned char type);
+void searchstore_remove(struct map_session_data* sd);
 
 #endif /* SEARCHSTORE_HPP */
@@ -4,6 +4,7 @@
 #include "skill.hpp"
 
 #include <array>
+#include <vector>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -71,7 +72,13 @@ static struct eri *skill_unit_ers = NULL; //For handling skill_unit's [Skotlex]
 static struct eri *skill_timer_ers = NULL; //For handling skill_timerskills [Skotlex]
 static DBMap* bowling_db = NULL; // int mob_id -> struct mob_data*
 
-DBMap* skillunit_db = NULL; // int id -> struct skill_unit*
+/**
+ * Alive skill units, stored contiguously so skill_unit_timer can walk them without a tree traversal.
+ * Entries removed while the timer is running are only cleared and compacted afterwards.
+ */
+static std::vector<struct skill_unit*> skillunit_list;
+static bool skillunit_list_locked = false;
+static bool skillunit_list_holes = false;
 
 /**
  * Skill Unit Persistency during endack routes (mostly for songs see bugreport:4574)
@@ -18690,8 +18697,11 @@ struct skill_unit *skill_initunit(struct skill_unit_group *group, int idx, int x
 	if( map_getcell(map_id2bl(group->src_id)->m, x, y, CELL_CHKMAELSTROM) )
 		return unit;
 
-	if(!unit->alive)
+	if(!unit->alive) {
 		group->alive_count++;
+		unit->list_index = (int)skillunit_list.size();
+		skillunit_list.push_back(unit);
+	}
 
 	unit->bl.id = map_get_new_object_id();
 	unit->bl.type = BL_SKILL;
@@ -18704,8 +18714,6 @@ struct skill_unit *skill_initunit(struct skill_unit_group *group, int idx, int x
 	unit->val2 = val2;
 	unit->hidden = hidden;
 
-	// Stores new skill unit
-	idb_put(skillunit_db, unit->bl.id, unit);
 	map_addiddb(&unit->bl);
 	if(map_addblock(&unit->bl))
 		return NULL;
@@ -18738,6 +18746,27 @@ struct skill_unit *skill_initunit(struct skill_unit_group *group, int idx, int x
 	return unit;
 }
 
+/**
+ * Remove unit from the list of alive skill units
+ * @param unit
+ */
+static void skill_unit_list_remove(struct skill_unit* unit)
+{
+	int i = unit->list_index;
+
+	if( skillunit_list_locked ) { // skill_unit_timer is walking the list, keep the positions
+		skillunit_list[i] = NULL;
+		skillunit_list_holes = true;
+		return;
+	}
+
+	struct skill_unit* last = skillunit_list.back();
+
+	skillunit_list[i] = last;
+	last->list_index = i;
+	skillunit_list.pop_back();
+}
+
 /**
  * Remove unit
  * @param unit
@@ -18811,7 +18840,7 @@ int skill_delunit(struct skill_unit* unit)
 	unit->group=NULL;
 	map_delblock(&unit->bl); // don't free yet
 	map_deliddb(&unit->bl);
-	idb_remove(skillunit_db, unit->bl.id);
+	skill_unit_list_remove(unit);
 	if(--group->alive_count==0)
 		skill_delunitgroup(group);
 
@@ -19187,14 +19216,11 @@ int skill_unit_timer_sub_onplace(struct block_list* bl, va_list ap)
 }
 
 /**
- * @see DBApply
- * Sub function of skill_unit_timer for executing each skill unit from skillunit_db
+ * Sub function of skill_unit_timer for executing each alive skill unit
  */
-static int skill_unit_timer_sub(DBKey key, DBData *data, va_list ap)
+static int skill_unit_timer_sub(struct skill_unit* unit, t_tick tick)
 {
-	struct skill_unit* unit = (struct skill_unit*)db_data2ptr(data);
 	struct skill_unit_group* group = NULL;
-	t_tick tick = va_arg(ap,t_tick);
 	bool dissonance;
 	struct block_list* bl = &unit->bl;
 
@@ -19458,8 +19484,28 @@ static int skill_unit_timer_sub(DBKey key, DBData *data, va_list ap)
  *------------------------------------------*/
 TIMER_FUNC(skill_unit_timer){
 	map_freeblock_lock();
+	skillunit_list_locked = true;
+
+	// Units placed during the run are appended and processed as well
+	for( size_t i = 0; i < skillunit_list.size(); i++ ) {
+		if( skillunit_list[i] != NULL )
+			skill_unit_timer_sub(skillunit_list[i], tick);
+	}
 
-	skillunit_db->foreach(skillunit_db, skill_unit_timer_sub, tick);
+	skillunit_list_locked = false;
+
+	if( skillunit_list_holes ) { // Compact the list of units removed during the run
+		size_t n = 0;
+
+		for( size_t i = 0; i < skillunit_list.size(); i++ ) {
+			if( skillunit_list[i] == NULL )
+				continue;
+			skillunit_list[i]->list_index = (int)n;
+			skillunit_list[n++] = skillunit_list[i];
+		}
+		skillunit_list.resize(n);
+		skillunit_list_holes = false;
+	}
 
 	map_freeblock_unlock();
 	return 0;
@@ -23131,7 +23177,6 @@ void do_init_skill(void)
 	skill_readdb();
 
 	skillunit_group_db = idb_alloc(DB_OPT_BASE);
-	skillunit_db = idb_alloc(DB_OPT_BASE);
 	skillusave_db = idb_alloc(DB_OPT_RELEASE_DATA);
 	bowling_db = idb_alloc(DB_OPT_BASE);
 	skill_unit_ers = ers_new(sizeof(struct skill_unit_group),"skill.cpp::skill_unit_ers",ERS_CACHE_OPTIONS);
@@ -23152,7 +23197,6 @@ void do_init_skill(void)
 void do_final_skill(void)
 {
 	db_destroy(skillunit_group_db);
-	db_destroy(skillunit_db);
 	db_destroy(skillusave_db);
 	db_destroy(bowling_db);
 	ers_destroy(skill_unit_ers);
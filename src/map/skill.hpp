@@ -376,6 +376,7 @@ struct skill_unit {
 	t_tick limit;
 	int val1, val2;
 	short range;
+	int list_index; /// Position in the list of alive skill units, only valid while alive
 	unsigned alive : 1;
 	unsigned hidden : 1;
 };
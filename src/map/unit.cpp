@@ -3348,6 +3348,11 @@ int unit_free(struct block_list *bl, clr_type clrtype)
 			}
 			sd->qi_count = 0;
 
+			if (sd->inventorylist_cache) {
+				aFree(sd->inventorylist_cache);
+				sd->inventorylist_cache = NULL;
+			}
+
 #if PACKETVER >= 20150513
 			if( sd->hatEffectCount > 0 ){
 				aFree(sd->hatEffectIDs);
@@ -3359,6 +3364,14 @@ int unit_free(struct block_list *bl, clr_type clrtype)
 			if (sd->achievement_data.achievements)
 				achievement_free(sd);
 
+			if (sd->save_base) {
+				aFree(sd->save_base);
+				sd->save_base = NULL;
+			}
+
+			intif_storage_freebase(sd);
+			searchstore_remove(sd); // no index may point to freed player data
+
 			// Clearing...
 			if (sd->bonus_script.head)
 				pc_bonus_script_clear(sd, BSF_REM_ALL);
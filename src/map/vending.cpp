@@ -4,6 +4,8 @@
 #include "vending.hpp"
 
 #include <stdlib.h> // atoi
+#include <unordered_map>
+#include <vector>
 
 #include "../common/malloc.hpp" // aMalloc, aFree
 #include "../common/nullpo.hpp"
@@ -71,6 +73,7 @@ void vending_closevending(struct map_session_data* sd)
 		sd->vender_id = 0;
 		clif_closevendingboard(&sd->bl, 0);
 		idb_remove(vending_db, sd->status.char_id);
+		searchstore_update(sd, SEARCHTYPE_VENDING);
 	}
 }
 
@@ -411,6 +414,7 @@ void vending_purchasereq(struct map_session_data* sd, int aid, int uid, const ui
 	}
 
 	vsd->vend_num = cursor;
+	searchstore_update(vsd, SEARCHTYPE_VENDING);
 
 	//Always save BOTH: customer (buyer) and vender
 	if( save_settings&CHARSAVE_VENDING ) {
@@ -536,6 +540,7 @@ int8 vending_openvending(struct map_session_data* sd, const char* message, const
 	clif_showvendingboard(&sd->bl,message,0);
 
 	idb_put(vending_db, sd->status.char_id, sd);
+	searchstore_update(sd, SEARCHTYPE_VENDING);
 
 	return 0;
 }
@@ -708,18 +713,19 @@ void do_init_vending_autotrade(void)
 		if (Sql_Query(mmysql_handle,
 			"SELECT `id`, `account_id`, `char_id`, `sex`, `title`, `body_direction`, `head_direction`, `sit`, `extended_vending_item` "
 			"FROM `%s` "
-			"WHERE `autotrade` = 1 AND (SELECT COUNT(`vending_id`) FROM `%s` WHERE `vending_id` = `id`) > 0 "
+			"WHERE `autotrade` = 1 "
 			"ORDER BY `id`;",
-			vendings_table, vending_items_table ) != SQL_SUCCESS )
+			vendings_table ) != SQL_SUCCESS )
 		{
 			Sql_ShowDebug(mmysql_handle);
 			return;
 		}
 
 		if( Sql_NumRows(mmysql_handle) > 0 ) {
-			uint16 items = 0;
-			DBIterator *iter = NULL;
+			uint32 items = 0;
 			struct s_autotrader *at = NULL;
+			std::unordered_map<uint32, struct s_autotrader *> stores; // vending_id -> autotrader
+			std::unordered_map<uint32, std::vector<struct s_autotrade_entry *>> store_items; // vending_id -> items
 
 			// Init each autotrader data
 			while (SQL_SUCCESS == Sql_NextRow(mmysql_handle)) {
@@ -760,50 +766,57 @@ void do_init_vending_autotrade(void)
 					at->sd->state.block_action &= ~PCBLOCK_IMMUNE;
 				// Extended Vending System Fix Bug [CreativeSD]
 				at->sd->vend_loot = at->vend_loot;
-				chrif_authreq(at->sd, true);
 				uidb_put(vending_autotrader_db, at->char_id, at);
+				stores[at->id] = at;
 			}
 			Sql_FreeResult(mmysql_handle);
 
-			// Init items for each autotraders
-			iter = db_iterator(vending_autotrader_db);
-			for (at = (struct s_autotrader *)dbi_first(iter); dbi_exists(iter); at = (struct s_autotrader *)dbi_next(iter)) {
-				uint16 j = 0;
-
-				if (SQL_ERROR == Sql_Query(mmysql_handle,
-					"SELECT `cartinventory_id`, `amount`, `price` "
-					"FROM `%s` "
-					"WHERE `vending_id` = %d "
-					"ORDER BY `index` ASC;",
-					vending_items_table, at->id ) )
-				{
-					Sql_ShowDebug(mmysql_handle);
-					continue;
+			// Init items for all autotraders at once
+			if (SQL_ERROR == Sql_Query(mmysql_handle,
+				"SELECT `i`.`vending_id`, `i`.`cartinventory_id`, `i`.`amount`, `i`.`price` "
+				"FROM `%s` `i` JOIN `%s` `v` ON `v`.`id` = `i`.`vending_id` "
+				"WHERE `v`.`autotrade` = 1 "
+				"ORDER BY `i`.`vending_id`, `i`.`index` ASC;",
+				vending_items_table, vendings_table ) )
+			{
+				Sql_ShowDebug(mmysql_handle);
+			} else {
+				while (SQL_SUCCESS == Sql_NextRow(mmysql_handle)) {
+					struct s_autotrade_entry *entry;
+					char *data;
+					uint32 id;
+
+					Sql_GetData(mmysql_handle, 0, &data, NULL); id = atoi(data);
+
+					if (stores.find(id) == stores.end())
+						continue;
+
+					CREATE(entry, struct s_autotrade_entry, 1);
+					Sql_GetData(mmysql_handle, 1, &data, NULL); entry->cartinventory_id = atoi(data);
+					Sql_GetData(mmysql_handle, 2, &data, NULL); entry->amount = atoi(data);
+					Sql_GetData(mmysql_handle, 3, &data, NULL); entry->price = atoi(data);
+					store_items[id].push_back(entry);
 				}
+				Sql_FreeResult(mmysql_handle);
+			}
 
-				if (!(at->count = (uint16)Sql_NumRows(mmysql_handle))) {
-					map_quit(at->sd);
+			// Hand the list to each autotrader and queue its login
+			for (const auto &it : stores) {
+				std::vector<struct s_autotrade_entry *> &list = store_items[it.first];
+
+				at = it.second;
+
+				if (!(at->count = (uint16)list.size())) {
+					aFree(at->sd); // not logged in yet
 					vending_autotrader_remove(at, true);
 					continue;
 				}
 
-				//Init the list
 				CREATE(at->entries, struct s_autotrade_entry *, at->count);
-
-				//Add the item into list
-				j = 0;
-				while (SQL_SUCCESS == Sql_NextRow(mmysql_handle) && j < at->count) {
-					char *data;
-					CREATE(at->entries[j], struct s_autotrade_entry, 1);
-					Sql_GetData(mmysql_handle, 0, &data, NULL); at->entries[j]->cartinventory_id = atoi(data);
-					Sql_GetData(mmysql_handle, 1, &data, NULL); at->entries[j]->amount = atoi(data);
-					Sql_GetData(mmysql_handle, 2, &data, NULL); at->entries[j]->price = atoi(data);
-					j++;
-				}
-				items += j;
-				Sql_FreeResult(mmysql_handle);
+				memcpy(at->entries, list.data(), at->count * sizeof(struct s_autotrade_entry *));
+				items += at->count;
+				pc_autotrade_restore(at->sd);
 			}
-			dbi_destroy(iter);
 
 			ShowStatus("Done loading '" CL_WHITE "%d" CL_RESET "' vending autotraders with '" CL_WHITE "%d" CL_RESET "' items.\n", db_size(vending_autotrader_db), items);
 		}
@@ -816,6 +829,24 @@ void do_init_vending_autotrade(void)
 	}
 }
 
+/**
+ * Discard a restored autotrader that is not logged in yet, e.g. because its account is online already
+ * The player data is not freed.
+ * @param sd Player as autotrader
+ */
+void vending_autotrader_discard( struct map_session_data* sd ){
+	struct s_autotrader *at;
+
+	nullpo_retv(sd);
+
+	if (!(at = (struct s_autotrader *)uidb_get(vending_autotrader_db, sd->status.char_id)) || at->sd != sd)
+		return;
+
+	vending_autotrader_remove(at, true);
+	if (db_size(vending_autotrader_db) == 0)
+		vending_autotrader_db->clear(vending_autotrader_db, vending_autotrader_free);
+}
+
 /**
  * Remove an autotrader's data
  * @param at Autotrader
@@ -23,6 +23,7 @@ void do_init_vending(void);
 void do_init_vending_autotrade( void );
  
 void vending_reopen( struct map_session_data* sd );
+void vending_autotrader_discard( struct map_session_data* sd );
 void vending_closevending(struct map_session_data* sd);
 int8 vending_openvending(struct map_session_data* sd, const char* message, const uint8* data, int count, struct s_autotrader *at);
 void vending_vendinglistreq(struct map_session_data* sd, int id);
@@ -0,0 +1,310 @@
+// Copyright (c) rAthena Dev Teams - Licensed under GNU GPL
+// For more information, see LICENCE in the main folder
+
+// Replays a packet capture recorded by a server with 'packet_capture: yes' (conf/packet_athena.conf).
+// Every recorded session gets its own connection, the recorded data is sent with the recorded timing
+// (optionally accelerated) and everything the server answers is read and discarded.
+// The sessions log in with the recorded account and character but with outdated login ids, replaying
+// a map-server capture requires 'replay_auth: yes' in the char-server's conf/char_athena.conf.
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../common/cbasetypes.hpp"
+#include "../common/core.hpp"
+#include "../common/showmsg.hpp"
+#include "../common/socket.hpp"
+
+std::string capture_file;
+std::string host = "127.0.0.1";
+uint16 port = 5121;
+double speed = 1.0;
+size_t max_sessions = 0; // 0: all sessions
+
+struct s_replay_record {
+	uint32 tick;
+	size_t session;
+	size_t offset; // position of the data in the capture
+	uint32 length;
+};
+
+struct s_replay_session {
+	int sock;
+	bool skip; // inter-server connection, not replayed
+	bool ended;
+};
+
+std::vector<unsigned char> capture;
+std::vector<s_replay_record> records;
+std::vector<s_replay_session> sessions;
+
+static struct {
+	uint64 bytes_sent;
+	uint64 bytes_received;
+	uint32 connected;
+	uint32 connect_failed;
+	uint32 closed_by_server;
+	uint32 max_lag; // ms the replay fell behind the recorded timing
+} stats;
+
+// Reads the capture and assigns the records to sessions
+static bool read_capture(void)
+{
+	FILE* fp = fopen(capture_file.c_str(), "rb");
+
+	if (fp == NULL) {
+		ShowError("Failed to open capture file '%s'.\n", capture_file.c_str());
+		return false;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	capture.resize(ftell(fp));
+	fseek(fp, 0, SEEK_SET);
+
+	if (fread(capture.data(), 1, capture.size(), fp) != capture.size()) {
+		ShowError("Failed to read capture file '%s'.\n", capture_file.c_str());
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+
+	uint32 header[2];
+
+	if (capture.size() < sizeof(header)) {
+		ShowError("Capture file '%s' is too small.\n", capture_file.c_str());
+		return false;
+	}
+
+	memcpy(header, capture.data(), sizeof(header));
+
+	if (header[0] != PACKET_CAPTURE_MAGIC || header[1] != PACKET_CAPTURE_VERSION) {
+		ShowError("'%s' is not a packet capture or has an unsupported version.\n", capture_file.c_str());
+		return false;
+	}
+
+	std::unordered_map<uint32, size_t> open_sessions; // recorded fd -> session
+	size_t pos = sizeof(header);
+
+	while (pos + sizeof(struct s_packet_capture_record) <= capture.size()) {
+		struct s_packet_capture_record record;
+
+		memcpy(&record, &capture[pos], sizeof(record));
+		pos += sizeof(record);
+
+		if (pos + record.length > capture.size()) {
+			ShowWarning("Capture file '%s' is truncated, ignoring the last record.\n", capture_file.c_str());
+			break;
+		}
+
+		auto it = open_sessions.find(record.session);
+
+		if (record.length == 0) { // end of session
+			if (it != open_sessions.end()) {
+				records.push_back({ record.tick, it->second, pos, 0 });
+				open_sessions.erase(it);
+			}
+			continue;
+		}
+
+		size_t session;
+
+		if (it != open_sessions.end())
+			session = it->second;
+		else {
+			session = sessions.size();
+			open_sessions[record.session] = session;
+
+			// Servers logging into each other are captured until they are flagged as server
+			uint16 cmd = record.length >= 2 ? capture[pos] | (capture[pos + 1] << 8) : 0;
+
+			sessions.push_back({ -1, cmd == 0x2710 || cmd == 0x2af8, false });
+		}
+
+		records.push_back({ record.tick, session, pos, record.length });
+		pos += record.length;
+	}
+
+	return true;
+}
+
+// Reads and discards everything the server sent
+static void drain_sessions(void)
+{
+	static unsigned char buf[65536];
+
+	for (auto& session : sessions) {
+		if (session.sock < 0)
+			continue;
+
+		ssize_t len;
+
+		while ((len = recv(session.sock, buf, sizeof(buf), 0)) > 0)
+			stats.bytes_received += len;
+
+		if (len == 0 || (len < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+			close(session.sock);
+			session.sock = -1;
+			session.ended = true;
+			stats.closed_by_server++;
+		}
+	}
+}
+
+static bool connect_session(struct s_replay_session& session)
+{
+	struct sockaddr_in addr;
+	int yes = 1;
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = inet_addr(host.c_str());
+
+	if ((session.sock = socket(AF_INET, SOCK_STREAM, 0)) < 0 || connect(session.sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+		if (session.sock >= 0)
+			close(session.sock);
+		session.sock = -1;
+		session.ended = true;
+		stats.connect_failed++;
+		return false;
+	}
+
+	setsockopt(session.sock, IPPROTO_TCP, TCP_NODELAY, (char*)&yes, sizeof(yes));
+	fcntl(session.sock, F_SETFL, fcntl(session.sock, F_GETFL) | O_NONBLOCK);
+	stats.connected++;
+	return true;
+}
+
+static void send_record(struct s_replay_session& session, const s_replay_record& record)
+{
+	size_t sent = 0;
+
+	while (sent < record.length && session.sock >= 0) {
+		ssize_t len = send(session.sock, &capture[record.offset + sent], record.length - sent, 0);
+
+		if (len > 0) {
+			sent += len;
+			stats.bytes_sent += len;
+		} else if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			drain_sessions(); // the server is busy, keep reading its answers
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		} else {
+			close(session.sock);
+			session.sock = -1;
+			session.ended = true;
+			stats.closed_by_server++;
+		}
+	}
+}
+
+static void replay(void)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	for (const auto& record : records) {
+		struct s_replay_session& session = sessions[record.session];
+
+		if (session.skip || (max_sessions && record.session >= max_sessions))
+			continue;
+
+		auto due = start + std::chrono::microseconds((int64)((int64)record.tick * 1000 / speed));
+
+		while (std::chrono::steady_clock::now() < due) {
+			drain_sessions();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		uint32 lag = (uint32)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - due).count();
+
+		if (lag > stats.max_lag)
+			stats.max_lag = lag;
+
+		if (record.length == 0) { // recorded end of the session
+			if (session.sock >= 0) {
+				close(session.sock);
+				session.sock = -1;
+			}
+			session.ended = true;
+			continue;
+		}
+
+		if (session.ended || (session.sock < 0 && !connect_session(session)))
+			continue;
+
+		send_record(session, record);
+	}
+
+	// Give the server a moment to answer the last packets
+	auto end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+	while (std::chrono::steady_clock::now() < end) {
+		drain_sessions();
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	for (auto& session : sessions) {
+		if (session.sock >= 0)
+			close(session.sock);
+	}
+
+	uint64 elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+	ShowInfo("Replayed " CL_WHITE "%u" CL_RESET " sessions in " CL_WHITE "%" PRIu64 CL_RESET " ms (%u failed to connect, %u closed by the server).\n", stats.connected, elapsed, stats.connect_failed, stats.closed_by_server);
+	ShowInfo("Sent " CL_WHITE "%" PRIu64 CL_RESET " bytes, received " CL_WHITE "%" PRIu64 CL_RESET " bytes, fell behind the recorded timing by up to " CL_WHITE "%u" CL_RESET " ms.\n", stats.bytes_sent, stats.bytes_received, stats.max_lag);
+}
+
+static void process_args(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-host") == 0 && i + 1 < argc)
+			host = argv[++i];
+		else if (strcmp(argv[i], "-port") == 0 && i + 1 < argc)
+			port = (uint16)atoi(argv[++i]);
+		else if (strcmp(argv[i], "-speed") == 0 && i + 1 < argc)
+			speed = atof(argv[++i]);
+		else if (strcmp(argv[i], "-sessions") == 0 && i + 1 < argc)
+			max_sessions = (size_t)atoi(argv[++i]);
+		else
+			capture_file = argv[i];
+	}
+}
+
+int do_init(int argc, char** argv)
+{
+	process_args(argc, argv);
+
+	if (capture_file.empty() || speed <= 0) {
+		ShowInfo("Usage: %s <capture file> [-host <ip>] [-port <port>] [-speed <factor>] [-sessions <count>]\n", argv[0]);
+		ShowInfo("Replays a capture of conf/packet_athena.conf's packet_capture against a server, default 127.0.0.1:5121 at speed 1.\n");
+		ShowInfo("Map-server captures need 'replay_auth: yes' in conf/char_athena.conf of the test char-server.\n");
+		return 0;
+	}
+
+	ShowStatus("Reading capture file: %s\n", capture_file.c_str());
+
+	if (!read_capture())
+		return 0;
+
+	ShowStatus("Replaying %u records of %u sessions against %s:%u at %.2fx speed\n", (uint32)records.size(), (uint32)sessions.size(), host.c_str(), port, speed);
+	replay();
+
+	return 0;
+}
+
+void do_final(void)
+{
+}